@@ -0,0 +1,264 @@
+#include "AimSolver.hpp"
+#include "../entities/ProjectilePool.hpp"
+#include "../utils/MathUtils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+constexpr int BATCH_SIZE = 64;
+constexpr float WORM_GRID_CELL = 64.0f;
+constexpr std::uint32_t NO_WORM = 0xffffffffu;
+constexpr float FULL_TURN = 2.0f * static_cast<float>(M_PI);
+
+// Лучше больше урона, при равенстве — ближе к врагу
+bool isBetter(int damageA, float missA, int damageB, float missB) {
+  if (damageA != damageB)
+    return damageA > damageB;
+  return missA < missB;
+}
+} // namespace
+
+AimSolver::AimSolver(ThreadPool *pool) : AimSolver(pool, Config()) {}
+
+AimSolver::AimSolver(ThreadPool *pool, Config config)
+    : pool(pool), config(config) {}
+
+AimSolution AimSolver::solve(const Simulation &simulation,
+                             RandomStream rng) const {
+  AimSolution solution;
+  const Worm &shooter = simulation.getActiveWorm();
+  if (!shooter.isActive)
+    return solution;
+
+  auto started = std::chrono::steady_clock::now();
+  auto outOfTime = [&] {
+    if (config.timeBudget <= 0.0f)
+      return false;
+    std::chrono::duration<float> elapsed =
+        std::chrono::steady_clock::now() - started;
+    return elapsed.count() >= config.timeBudget;
+  };
+
+  // Сетка первого круга сдвинута на случайную фазу, чтобы разные ходы не
+  // упирались в одни и те же углы
+  float angleStep = FULL_TURN / config.angleSteps;
+  float powerStep = 100.0f / std::max(1, config.powerSteps - 1);
+  float phase = rng.uniform(0.0f, angleStep);
+
+  std::vector<Candidate> candidates;
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++) {
+    for (int a = 0; a < config.angleSteps; a++) {
+      for (int p = 0; p < config.powerSteps; p++) {
+        candidates.push_back({static_cast<GameTypes::WeaponType>(w),
+                              -static_cast<float>(M_PI) + phase + a * angleStep,
+                              std::min(100.0f, p * powerStep)});
+      }
+    }
+  }
+
+  // Червяки за время полета считаются неподвижными
+  const std::vector<Worm> &worms = simulation.getWorms();
+  SpatialGrid wormGrid(static_cast<float>(simulation.getTerrain().getWidth()),
+                       static_cast<float>(simulation.getTerrain().getHeight()),
+                       WORM_GRID_CELL);
+  wormGrid.rebuild(worms.size(),
+                   [&worms](std::size_t i) { return worms[i].getCenter(); });
+
+  std::vector<Outcome> outcomes;
+  evaluate(simulation, wormGrid, candidates, 0, outcomes);
+  solution.rounds = 1;
+
+  // Порядок кандидатов: лучший первым, при полном равенстве — раньше
+  // просчитанный. Так итог не зависит от того, какой поток что считал.
+  auto ranked = [&](std::size_t a, std::size_t b) {
+    const Outcome &oa = outcomes[a], &ob = outcomes[b];
+    if (oa.damage != ob.damage || oa.missDistance != ob.missDistance)
+      return isBetter(oa.damage, oa.missDistance, ob.damage, ob.missDistance);
+    return a < b;
+  };
+
+  std::vector<std::size_t> order;
+  for (int round = 1; round <= config.refineRounds && !outOfTime(); round++) {
+    order.resize(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::size_t keep =
+        std::min<std::size_t>(config.refineKeep, order.size());
+    std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                      ranked);
+
+    float scale = 1.0f / static_cast<float>(1 << round);
+    std::size_t first = candidates.size();
+    for (std::size_t k = 0; k < keep; k++) {
+      Candidate center = candidates[order[k]];
+      for (int i = -2; i <= 2; i++) {
+        for (int j = -2; j <= 2; j++) {
+          if (i == 0 && j == 0)
+            continue;
+          float power = center.power + j * powerStep * scale * 0.5f;
+          candidates.push_back(
+              {center.weapon, center.angle + i * angleStep * scale * 0.5f,
+               std::max(0.0f, std::min(100.0f, power))});
+        }
+      }
+    }
+    evaluate(simulation, wormGrid, candidates, first, outcomes);
+    solution.rounds++;
+  }
+
+  std::size_t best = 0;
+  for (std::size_t i = 1; i < candidates.size(); i++) {
+    if (ranked(i, best))
+      best = i;
+  }
+
+  const Candidate &shot = candidates[best];
+  solution.found = true;
+  solution.weapon = shot.weapon;
+  solution.aimDirection =
+      sf::Vector2f(std::cos(shot.angle), std::sin(shot.angle));
+  solution.aimPower = shot.power;
+  solution.expectedDamage = outcomes[best].damage;
+  solution.missDistance = outcomes[best].missDistance;
+  solution.evaluated = static_cast<int>(candidates.size());
+  return solution;
+}
+
+void AimSolver::evaluate(const Simulation &simulation,
+                         const SpatialGrid &wormGrid,
+                         const std::vector<Candidate> &candidates,
+                         std::size_t first,
+                         std::vector<Outcome> &outcomes) const {
+  outcomes.resize(candidates.size());
+  for (std::size_t begin = first; begin < candidates.size();
+       begin += BATCH_SIZE) {
+    int count = static_cast<int>(
+        std::min<std::size_t>(BATCH_SIZE, candidates.size() - begin));
+    const Candidate *batch = candidates.data() + begin;
+    Outcome *results = outcomes.data() + begin;
+    if (pool) {
+      pool->submit([this, &simulation, &wormGrid, batch, results, count] {
+        evaluateBatch(simulation, wormGrid, batch, results, count);
+      });
+    } else {
+      evaluateBatch(simulation, wormGrid, batch, results, count);
+    }
+  }
+  if (pool)
+    pool->wait();
+}
+
+void AimSolver::evaluateBatch(const Simulation &simulation,
+                              const SpatialGrid &wormGrid,
+                              const Candidate *candidates, Outcome *outcomes,
+                              int count) const {
+  const TerrainManager &terrain = simulation.getTerrain();
+  const std::vector<Worm> &worms = simulation.getWorms();
+  const Worm &shooter = simulation.getActiveWorm();
+  const float dt = 1.0f / GameTypes::SIM_TICK_RATE;
+  const int maxTicks = static_cast<int>(config.maxFlightTime / dt);
+  const float width = static_cast<float>(terrain.getWidth());
+  const float height = static_cast<float>(terrain.getHeight());
+
+  // Пачка траекторий в виде отдельных массивов: интегрирование идет одним
+  // циклом без ветвлений по всем дорожкам, и компилятор его векторизует
+  float x[BATCH_SIZE], y[BATCH_SIZE], vx[BATCH_SIZE], vy[BATCH_SIZE];
+  float nextX[BATCH_SIZE], nextY[BATCH_SIZE];
+  float gravity[BATCH_SIZE], travel[BATCH_SIZE], arming[BATCH_SIZE];
+  bool alive[BATCH_SIZE];
+
+  for (int i = 0; i < count; i++) {
+    const Candidate &c = candidates[i];
+    sf::Vector2f direction(std::cos(c.angle), std::sin(c.angle));
+    sf::Vector2f start =
+        shooter.getCenter() + direction * GameTypes::MUZZLE_OFFSET;
+    float speed = GameTypes::launchSpeed(c.weapon, c.power);
+    x[i] = start.x;
+    y[i] = start.y;
+    vx[i] = direction.x * speed;
+    vy[i] = direction.y * speed;
+    gravity[i] = GameTypes::projectileGravity(c.weapon);
+    travel[i] = 0.0f;
+    arming[i] = ProjectilePool::armingDistance(c.weapon);
+    alive[i] = true;
+    outcomes[i] = Outcome();
+    outcomes[i].missDistance = std::numeric_limits<float>::max();
+  }
+
+  int aliveCount = count;
+  for (int tick = 0; tick < maxTicks && aliveCount > 0; tick++) {
+    for (int i = 0; i < count; i++) {
+      vy[i] += gravity[i] * dt;
+      nextX[i] = x[i] + vx[i] * dt;
+      nextY[i] = y[i] + vy[i] * dt;
+    }
+
+    // Столкновения — как в ProjectilePool::update и Simulation::step.
+    // Пробитие снайперской пули и осколки гранаты не моделируются, так что
+    // оценка для них получается заниженной.
+    for (int i = 0; i < count; i++) {
+      if (!alive[i])
+        continue;
+      sf::Vector2f from(x[i], y[i]);
+      sf::Vector2f to(nextX[i], nextY[i]);
+      sf::Vector2f hitPoint;
+      bool hitTerrain = terrain.findFirstCollision(from, to, hitPoint);
+      if (hitTerrain)
+        to = hitPoint;
+      travel[i] += MathUtils::length(to - from);
+      x[i] = to.x;
+      y[i] = to.y;
+
+      Outcome &outcome = outcomes[i];
+      // В местность снаряд взрывается без урона червякам, но воронка рядом
+      // с врагом раскапывает его к следующему ходу
+      bool done = hitTerrain || to.y > height || to.x < 0 || to.x > width;
+      if (hitTerrain) {
+        for (const auto &worm : worms) {
+          if (worm.isActive && worm.teamId != shooter.teamId) {
+            outcome.missDistance =
+                std::min(outcome.missDistance,
+                         MathUtils::distance(to, worm.getCenter()));
+          }
+        }
+      }
+      if (!done && travel[i] >= arming[i]) {
+        // Первый по порядку задетый червяк, как в Simulation::step
+        std::uint32_t hitWorm = NO_WORM;
+        wormGrid.forEachNear(
+            to, ProjectilePool::WORM_HIT_DISTANCE, [&](std::uint32_t index) {
+              const Worm &worm = worms[index];
+              if (index < hitWorm && worm.isActive &&
+                  MathUtils::distance(to, worm.getCenter()) <
+                      ProjectilePool::WORM_HIT_DISTANCE)
+                hitWorm = index;
+            });
+
+        if (hitWorm != NO_WORM) {
+          GameTypes::WeaponType weapon = candidates[i].weapon;
+          float radius =
+              static_cast<float>(GameTypes::weaponExplosionRadius(weapon));
+          wormGrid.forEachNear(to, radius, [&](std::uint32_t index) {
+            const Worm &target = worms[index];
+            if (!target.isActive)
+              return;
+            bool sameTeam = target.teamId == shooter.teamId;
+            int damage = Simulation::explosionDamage(
+                GameTypes::weaponDamage(weapon), radius,
+                MathUtils::distance(to, target.getCenter()), sameTeam);
+            damage = std::min(damage, target.health);
+            outcome.damage += sameTeam ? -damage : damage;
+          });
+          done = true;
+        }
+      }
+
+      if (done) {
+        alive[i] = false;
+        aliveCount--;
+      }
+    }
+  }
+}
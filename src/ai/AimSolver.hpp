@@ -0,0 +1,71 @@
+#pragma once
+#include "../game/Simulation.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/SpatialGrid.hpp"
+#include "../utils/ThreadPool.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+// Лучший выстрел, найденный перебором
+struct AimSolution {
+  bool found = false;
+  GameTypes::WeaponType weapon = GameTypes::WeaponType::BAZOOKA;
+  sf::Vector2f aimDirection{1.0f, 0.0f};
+  float aimPower = 0.0f;
+  int expectedDamage = 0;    // урон врагам минус урон своим
+  float missDistance = 0.0f; // от воронки до врага, если попадания нет
+  int evaluated = 0;         // просчитано траекторий
+  int rounds = 0;            // пройдено кругов уточнения
+};
+
+// Наведение компьютерного червяка: перебор угол × мощность × оружие.
+// Траектории считаются пачками по тому же шагу, что и в симуляции, пачки
+// раздаются пулу потоков. Кандидаты оцениваются уроном по формуле
+// Simulation::explosionDamage (своим — треть) за вычетом урона своим.
+//
+// Первый круг — равномерная сетка, затем несколько лучших кандидатов
+// уточняются сеткой с вдвое меньшим шагом, пока хватает бюджета времени.
+// Результат зависит только от состояния матча и rng; бюджет лишь решает,
+// сколько кругов уточнения успеет пройти. С нулевым бюджетом проходят все
+// круги, и выстрел воспроизводим на любой машине.
+class AimSolver {
+public:
+  struct Config {
+    int angleSteps = 48;
+    int powerSteps = 5;
+    int refineRounds = 3;
+    int refineKeep = 4;        // сколько лучших кандидатов уточнять
+    float timeBudget = 0.005f; // секунды на ход, 0 — без ограничения
+    float maxFlightTime = 5.0f;
+  };
+
+  // Без пула все считается в вызывающем потоке. solve() ждет весь пул,
+  // поэтому пул не стоит делить с другой работой.
+  explicit AimSolver(ThreadPool *pool);
+  AimSolver(ThreadPool *pool, Config config);
+
+  AimSolution solve(const Simulation &simulation, RandomStream rng) const;
+
+private:
+  struct Candidate {
+    GameTypes::WeaponType weapon;
+    float angle;
+    float power;
+  };
+
+  struct Outcome {
+    int damage = 0;
+    float missDistance = 0.0f;
+  };
+
+  void evaluate(const Simulation &simulation, const SpatialGrid &wormGrid,
+                const std::vector<Candidate> &candidates, std::size_t first,
+                std::vector<Outcome> &outcomes) const;
+  void evaluateBatch(const Simulation &simulation, const SpatialGrid &wormGrid,
+                     const Candidate *candidates, Outcome *outcomes,
+                     int count) const;
+
+  ThreadPool *pool;
+  Config config;
+};
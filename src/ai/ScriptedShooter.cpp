@@ -0,0 +1,93 @@
+#include "ScriptedShooter.hpp"
+#include "../utils/MathUtils.hpp"
+#include <cmath>
+
+namespace {
+// Пауза перед выстрелом, чтобы червяк успел приземлиться
+constexpr float THINK_TIME = 0.5f;
+} // namespace
+
+ScriptedShooter::ScriptedShooter(Mode mode, RandomStream rng,
+                                 const AimSolver *solver)
+    : mode(mode), rng(rng), solver(solver) {}
+
+PlayerInput ScriptedShooter::decide(const Simulation &simulation) {
+  PlayerInput input;
+  const Worm &activeWorm = simulation.getActiveWorm();
+
+  // Стреляем, только когда предыдущий снаряд долетел
+  if (!activeWorm.isActive || !activeWorm.isMyTurn ||
+      !simulation.canActiveWormShoot() ||
+      !simulation.getProjectiles().empty() ||
+      simulation.getTurnTime() < THINK_TIME) {
+    return input;
+  }
+
+  if (mode == Mode::SEARCH && solver) {
+    AimSolution solution = solver->solve(simulation, rng.split(rng.nextU64()));
+    if (solution.found) {
+      input.selectWeapon = true;
+      input.weapon = solution.weapon;
+      input.aimDirection = solution.aimDirection;
+      input.aimPower = solution.aimPower;
+      input.shoot = true;
+      return input;
+    }
+  }
+
+  input.selectWeapon = true;
+  input.weapon = static_cast<GameTypes::WeaponType>(
+      rng.uniformInt(0, GameTypes::WEAPON_COUNT - 1));
+  input.shoot = true;
+
+  if (mode == Mode::AIMED && aimAtNearestEnemy(simulation, input))
+    return input;
+
+  // Случайный выстрел в верхнюю полуплоскость
+  float angle = rng.uniform(-M_PI, 0.0f);
+  input.aimDirection = sf::Vector2f(std::cos(angle), std::sin(angle));
+  input.aimPower = rng.uniform(0.0f, 100.0f);
+  return input;
+}
+
+bool ScriptedShooter::aimAtNearestEnemy(const Simulation &simulation,
+                                        PlayerInput &input) {
+  const Worm &shooter = simulation.getActiveWorm();
+  const Worm *target = nullptr;
+  float bestDistance = 0.0f;
+  for (const auto &worm : simulation.getWorms()) {
+    if (!worm.isActive || worm.teamId == shooter.teamId)
+      continue;
+    float distance = MathUtils::distance(worm.position, shooter.position);
+    if (!target || distance < bestDistance) {
+      target = &worm;
+      bestDistance = distance;
+    }
+  }
+  if (!target)
+    return false;
+
+  // Скорость вылета как в Simulation::shoot при полной мощности
+  float gravity = GameTypes::projectileGravity(input.weapon);
+  input.aimPower = 100.0f;
+  float speed = GameTypes::launchSpeed(input.weapon, input.aimPower);
+
+  // Угол вылета для попадания в точку (dx, dy) при ускорении g вниз:
+  // tan = (v^2 - sqrt(v^4 - g(g dx^2 - 2 dy v^2))) / (g dx), y направлен вниз
+  float dx = target->position.x - shooter.position.x;
+  float dy = target->position.y - shooter.position.y;
+  float v2 = speed * speed;
+  float discriminant = v2 * v2 - gravity * (gravity * dx * dx - 2 * dy * v2);
+  float angle;
+  if (discriminant < 0 || std::abs(dx) < 1.0f) {
+    angle = dx >= 0 ? -M_PI / 4 : -3 * M_PI / 4;
+  } else {
+    float tanTheta = (v2 - std::sqrt(discriminant)) / (gravity * std::abs(dx));
+    float elevation = std::atan(tanTheta);
+    angle = dx >= 0 ? -elevation : -M_PI + elevation;
+  }
+
+  angle += rng.uniform(-0.05f, 0.05f);
+  input.aimDirection = sf::Vector2f(std::cos(angle), std::sin(angle));
+  return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "../game/PlayerInput.hpp"
+#include "../game/Simulation.hpp"
+#include "../utils/Random.hpp"
+#include "AimSolver.hpp"
+
+// Простой стрелок для безголовых матчей и ботов. RANDOM бьет в случайном
+// направлении, AIMED наводится на ближайшего врага по баллистической формуле
+// с небольшим разбросом, SEARCH берет лучший выстрел из AimSolver.
+class ScriptedShooter {
+public:
+  enum class Mode { RANDOM, AIMED, SEARCH };
+
+  // Для SEARCH нужен solver, он должен жить дольше стрелка
+  ScriptedShooter(Mode mode, RandomStream rng,
+                  const AimSolver *solver = nullptr);
+
+  // Ввод активного игрока на очередной тик
+  PlayerInput decide(const Simulation &simulation);
+
+private:
+  bool aimAtNearestEnemy(const Simulation &simulation, PlayerInput &input);
+
+  Mode mode;
+  RandomStream rng;
+  const AimSolver *solver;
+};
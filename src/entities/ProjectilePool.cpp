@@ -0,0 +1,307 @@
+#include "ProjectilePool.hpp"
+#include "../utils/MathUtils.hpp"
+#include <climits>
+#include <cmath>
+
+ProjectilePool::ProjectilePool(std::size_t initialCapacity) {
+  if (initialCapacity == 0)
+    initialCapacity = 1;
+  freeSlots.reserve(initialCapacity);
+  liveSlots.reserve(initialCapacity);
+  while (generations.size() < initialCapacity)
+    grow();
+}
+
+void ProjectilePool::grow() {
+  // Удваиваем все массивы разом; новые слоты уходят в список свободных
+  std::size_t oldCapacity = generations.size();
+  std::size_t newCapacity = oldCapacity == 0 ? 1 : oldCapacity * 2;
+
+  positions.resize(newCapacity);
+  previousPositions.resize(newCapacity);
+  velocities.resize(newCapacity);
+  weaponTypes.resize(newCapacity);
+  activeFlags.resize(newCapacity, 0);
+  launchingFlags.resize(newCapacity, 0);
+  shrapnelFlags.resize(newCapacity, 0);
+  damages.resize(newCapacity);
+  explosionRadii.resize(newCapacity);
+  shooterTeams.resize(newCapacity);
+  launchTimers.resize(newCapacity);
+  totalTimes.resize(newCapacity);
+  travelDistances.resize(newCapacity);
+  penetrationPowers.resize(newCapacity);
+  rngs.resize(newCapacity);
+  trails.resize(newCapacity);
+  generations.resize(newCapacity, 0);
+
+  freeSlots.reserve(newCapacity);
+  liveSlots.reserve(newCapacity);
+  // Кладем в обратном порядке, чтобы слоты выдавались по возрастанию
+  for (std::size_t i = newCapacity; i > oldCapacity; i--)
+    freeSlots.push_back(static_cast<std::uint32_t>(i - 1));
+}
+
+std::uint32_t ProjectilePool::allocateSlot() {
+  if (freeSlots.empty())
+    grow();
+  std::uint32_t slot = freeSlots.back();
+  freeSlots.pop_back();
+  liveSlots.push_back(slot);
+  return slot;
+}
+
+ProjectileHandle ProjectilePool::spawn(sf::Vector2f position,
+                                       sf::Vector2f velocity, int team,
+                                       GameTypes::WeaponType type,
+                                       RandomStream rng) {
+  std::uint32_t slot = allocateSlot();
+
+  positions[slot] = position;
+  previousPositions[slot] = position;
+  velocities[slot] = velocity;
+  weaponTypes[slot] = type;
+  shooterTeams[slot] = team;
+  shrapnelFlags[slot] = 0;
+  rngs[slot] = rng;
+  trails.reset(slot, GameTypes::trailLength(type));
+
+  damages[slot] = GameTypes::weaponDamage(type);
+  explosionRadii[slot] = GameTypes::weaponExplosionRadius(type);
+  // Снайперская пуля пробивает до трех препятствий
+  penetrationPowers[slot] =
+      (type == GameTypes::WeaponType::SNIPER_RIFLE) ? 3.0f : 0.0f;
+
+  activeFlags[slot] = 1;
+  launchingFlags[slot] = 1;
+  launchTimers[slot] = 0.2f;
+  totalTimes[slot] = 0.0f;
+  travelDistances[slot] = 0.0f;
+
+  ProjectileHandle handle;
+  handle.slot = slot;
+  handle.generation = generations[slot];
+  return handle;
+}
+
+bool ProjectilePool::isAlive(ProjectileHandle handle) const {
+  return handle.slot < generations.size() &&
+         generations[handle.slot] == handle.generation &&
+         activeFlags[handle.slot];
+}
+
+void ProjectilePool::clear() {
+  for (std::uint32_t slot : liveSlots) {
+    activeFlags[slot] = 0;
+  }
+  releaseInactive();
+}
+
+void ProjectilePool::releaseInactive() {
+  // Порядок живых слотов сохраняется: от него зависит порядок обновления
+  std::size_t kept = 0;
+  for (std::uint32_t slot : liveSlots) {
+    if (activeFlags[slot]) {
+      liveSlots[kept++] = slot;
+    } else {
+      generations[slot]++;
+      freeSlots.push_back(slot);
+    }
+  }
+  liveSlots.resize(kept);
+}
+
+void ProjectilePool::write(ByteWriter &out) const {
+  out.varint(liveSlots.size());
+  for (std::uint32_t slot : liveSlots) {
+    out.u8(static_cast<std::uint8_t>(weaponTypes[slot]));
+    out.u8(activeFlags[slot] | launchingFlags[slot] << 1 |
+           shrapnelFlags[slot] << 2);
+    out.f32(positions[slot].x);
+    out.f32(positions[slot].y);
+    out.f32(previousPositions[slot].x);
+    out.f32(previousPositions[slot].y);
+    out.f32(velocities[slot].x);
+    out.f32(velocities[slot].y);
+    out.svarint(damages[slot]);
+    out.svarint(explosionRadii[slot]);
+    out.svarint(shooterTeams[slot]);
+    out.f32(launchTimers[slot]);
+    out.f32(totalTimes[slot]);
+    out.f32(travelDistances[slot]);
+    out.f32(penetrationPowers[slot]);
+    out.u64(rngs[slot].getKey());
+    out.varint(rngs[slot].getCounter());
+  }
+}
+
+bool ProjectilePool::read(ByteReader &in) {
+  clear();
+  std::uint64_t count = in.varint();
+  // Снаряд занимает не меньше 50 байт: число из испорченных данных не
+  // раздувает пул
+  if (!in.ok() || count > in.remaining() / 50)
+    return false;
+  for (std::uint64_t i = 0; i < count; i++) {
+    std::uint8_t type = in.u8();
+    std::uint8_t flags = in.u8();
+    if (type >= GameTypes::WEAPON_COUNT)
+      return false;
+    sf::Vector2f position, previous, velocity;
+    position.x = in.f32();
+    position.y = in.f32();
+    previous.x = in.f32();
+    previous.y = in.f32();
+    velocity.x = in.f32();
+    velocity.y = in.f32();
+    if (!MathUtils::isWithin(position, TerrainManager::MAX_COORDINATE) ||
+        !MathUtils::isWithin(previous, TerrainManager::MAX_COORDINATE) ||
+        !MathUtils::isWithin(velocity, TerrainManager::MAX_COORDINATE))
+      return false;
+    std::uint32_t slot =
+        spawn(position, velocity, 0, static_cast<GameTypes::WeaponType>(type),
+              RandomStream())
+            .slot;
+    previousPositions[slot] = previous;
+    activeFlags[slot] = flags & 1;
+    launchingFlags[slot] = (flags >> 1) & 1;
+    shrapnelFlags[slot] = (flags >> 2) & 1;
+    // Урон и радиус идут в вычитание здоровья и в воронку: проверяем до
+    // приведения к int
+    std::int64_t damage = in.svarint();
+    std::int64_t radius = in.svarint();
+    std::int64_t team = in.svarint();
+    if (damage < 0 || damage > INT_MAX || radius < 0 ||
+        radius > TerrainManager::MAX_DESTRUCTION_RADIUS || team < 0 ||
+        team > INT_MAX)
+      return false;
+    damages[slot] = static_cast<int>(damage);
+    explosionRadii[slot] = static_cast<int>(radius);
+    shooterTeams[slot] = static_cast<int>(team);
+    launchTimers[slot] = in.f32();
+    totalTimes[slot] = in.f32();
+    travelDistances[slot] = in.f32();
+    penetrationPowers[slot] = in.f32();
+    std::uint64_t key = in.u64();
+    rngs[slot] = RandomStream::fromState(key, in.varint());
+  }
+  return in.ok();
+}
+
+void ProjectilePool::update(std::uint32_t slot, float deltaTime,
+                            TerrainManager &terrain) {
+  sf::Vector2f &position = positions[slot];
+  previousPositions[slot] = position;
+  if (!activeFlags[slot])
+    return;
+
+  totalTimes[slot] += deltaTime;
+
+  if (launchingFlags[slot]) {
+    launchTimers[slot] -= deltaTime;
+    if (launchTimers[slot] <= 0) {
+      launchingFlags[slot] = 0;
+    }
+    return;
+  }
+
+  sf::Vector2f oldPosition = position;
+  GameTypes::WeaponType weaponType = weaponTypes[slot];
+
+  velocities[slot].y += GameTypes::projectileGravity(weaponType) * deltaTime;
+
+  position += velocities[slot] * deltaTime;
+
+  // Проверяем коллизию с местностью по всему отрезку шага, а не только в
+  // конечной точке: быстрый снаряд иначе проскакивает тонкие стенки
+  bool hitTerrain = false;
+  sf::Vector2f segmentStart = oldPosition;
+  sf::Vector2f hitPoint;
+  while (terrain.findFirstCollision(segmentStart, position, hitPoint)) {
+    // Снайперская винтовка может пробивать препятствия
+    if (weaponType == GameTypes::WeaponType::SNIPER_RIFLE &&
+        penetrationPowers[slot] > 0) {
+      terrain.destroyTerrain(static_cast<int>(hitPoint.x),
+                             static_cast<int>(hitPoint.y), 3);
+      penetrationPowers[slot] -= 1.0f;
+      if (penetrationPowers[slot] > 0) {
+        segmentStart = hitPoint;
+        continue;
+      }
+    }
+    position = hitPoint;
+    hitTerrain = true;
+    break;
+  }
+
+  sf::Vector2f deltaPos = position - oldPosition;
+  travelDistances[slot] += MathUtils::length(deltaPos);
+
+  // След снаряда
+  trails.push(slot, position);
+
+  if (hitTerrain) {
+    explode(slot, terrain);
+    return;
+  }
+
+  // Проверяем границы карты
+  if (position.y > terrain.getHeight() || position.x < 0 ||
+      position.x > terrain.getWidth()) {
+    activeFlags[slot] = 0;
+  }
+}
+
+void ProjectilePool::explode(std::uint32_t slot, TerrainManager &terrain) {
+  terrain.destroyTerrain(static_cast<int>(positions[slot].x),
+                         static_cast<int>(positions[slot].y),
+                         explosionRadii[slot]);
+
+  // Осколочная граната разлетается осколками — обычными снарядами пула
+  if (weaponTypes[slot] == GameTypes::WeaponType::FRAG_GRENADE &&
+      !shrapnelFlags[slot]) {
+    spawnShrapnel(slot);
+  }
+
+  activeFlags[slot] = 0;
+}
+
+void ProjectilePool::spawnShrapnel(std::uint32_t parent) {
+  // Создаем 8 осколков. Слоты могут переехать при росте пула, поэтому
+  // нужные поля родителя копируем заранее.
+  sf::Vector2f origin = positions[parent];
+  int team = shooterTeams[parent];
+  RandomStream rng = rngs[parent];
+  for (int i = 0; i < 8; i++) {
+    float angle = rng.uniform(0.0f, 2.0f * M_PI);
+    float speed = rng.uniform(150.0f, 300.0f);
+    sf::Vector2f velocity(cos(angle) * speed, sin(angle) * speed);
+
+    std::uint32_t slot = spawn(origin, velocity, team,
+                               GameTypes::WeaponType::BAZOOKA, rng.split(i))
+                             .slot;
+    damages[slot] = 15;
+    explosionRadii[slot] = 8;
+    shrapnelFlags[slot] = 1;
+    // Осколки разлетаются сразу, без задержки вылета
+    launchingFlags[slot] = 0;
+  }
+  rngs[parent] = rng;
+}
+
+GameTypes::WeaponType ProjectilePool::getSourceWeapon(std::uint32_t slot) const {
+  return shrapnelFlags[slot] ? GameTypes::WeaponType::FRAG_GRENADE
+                             : weaponTypes[slot];
+}
+
+bool ProjectilePool::checkWormCollision(std::uint32_t slot,
+                                        const Worm &worm) const {
+  if (!activeFlags[slot] || !worm.isActive || launchingFlags[slot])
+    return false;
+
+  if (travelDistances[slot] < armingDistance(weaponTypes[slot]))
+    return false;
+
+  float distanceLength = MathUtils::distance(positions[slot], worm.getCenter());
+  return distanceLength < WORM_HIT_DISTANCE;
+}
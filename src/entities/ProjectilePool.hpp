@@ -0,0 +1,86 @@
+#pragma once
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/BinaryIO.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include "TrailArena.hpp"
+#include "Worm.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// Ссылка на снаряд в пуле. Поколение слота растет при каждом освобождении,
+// поэтому устаревшая ссылка на переиспользованный слот распознается.
+struct ProjectileHandle {
+  static constexpr std::uint32_t INVALID = 0xffffffffu;
+  std::uint32_t slot = INVALID;
+  std::uint32_t generation = 0;
+};
+
+// Все снаряды и осколки матча в одном плоском пуле: каждое поле хранится
+// отдельным массивом по номеру слота (structure of arrays). Свободные слоты
+// переиспользуются, так что после прогрева взрывы не выделяют память.
+class ProjectilePool {
+public:
+  // Снаряд задевает червяка ближе этого расстояния до центра, но только
+  // пролетев armingDistance, чтобы не взорваться о стрелка
+  static constexpr float WORM_HIT_DISTANCE = 20.0f;
+  static constexpr float armingDistance(GameTypes::WeaponType type) {
+    return type == GameTypes::WeaponType::SNIPER_RIFLE ? 30.0f : 50.0f;
+  }
+
+  explicit ProjectilePool(std::size_t initialCapacity = 64);
+
+  ProjectileHandle spawn(sf::Vector2f position, sf::Vector2f velocity,
+                         int team, GameTypes::WeaponType type,
+                         RandomStream rng);
+  bool isAlive(ProjectileHandle handle) const;
+  void clear();
+
+  // Занятые слоты в порядке обновления
+  const std::vector<std::uint32_t> &getLiveSlots() const { return liveSlots; }
+  std::size_t size() const { return liveSlots.size(); }
+  bool empty() const { return liveSlots.empty(); }
+  std::size_t capacity() const { return generations.size(); }
+
+  void update(std::uint32_t slot, float deltaTime, TerrainManager &terrain);
+  void explode(std::uint32_t slot, TerrainManager &terrain);
+  bool checkWormCollision(std::uint32_t slot, const Worm &worm) const;
+  // Оружие, которому засчитывается урон слота (осколки — гранате)
+  GameTypes::WeaponType getSourceWeapon(std::uint32_t slot) const;
+  // Возвращает погасшие слоты в список свободных
+  void releaseInactive();
+
+  // Живые снаряды в порядке обновления, без следов (они только для
+  // отрисовки). read() заменяет ими содержимое пула; номера слотов после
+  // чтения могут быть другими.
+  void write(ByteWriter &out) const;
+  bool read(ByteReader &in);
+
+  // Поля снарядов по номеру слота
+  std::vector<sf::Vector2f> positions;
+  std::vector<sf::Vector2f> previousPositions; // для интерполяции
+  std::vector<sf::Vector2f> velocities;
+  std::vector<GameTypes::WeaponType> weaponTypes;
+  std::vector<std::uint8_t> activeFlags;
+  std::vector<std::uint8_t> launchingFlags;
+  std::vector<std::uint8_t> shrapnelFlags;
+  std::vector<int> damages;
+  std::vector<int> explosionRadii;
+  std::vector<int> shooterTeams;
+  std::vector<float> launchTimers;
+  std::vector<float> totalTimes;
+  std::vector<float> travelDistances;
+  std::vector<float> penetrationPowers;
+  std::vector<RandomStream> rngs; // разлет осколков
+  TrailArena trails;
+
+private:
+  std::uint32_t allocateSlot();
+  void grow();
+  void spawnShrapnel(std::uint32_t parent);
+
+  std::vector<std::uint32_t> generations;
+  std::vector<std::uint32_t> freeSlots;
+  std::vector<std::uint32_t> liveSlots;
+};
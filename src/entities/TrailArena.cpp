@@ -0,0 +1,32 @@
+#include "TrailArena.hpp"
+#include <algorithm>
+
+void TrailArena::resize(std::size_t slots) {
+  points.resize(slots * MAX_LENGTH);
+  heads.resize(slots, 0);
+  counts.resize(slots, 0);
+  lengths.resize(slots, 1);
+}
+
+void TrailArena::reset(std::uint32_t slot, int length) {
+  heads[slot] = 0;
+  counts[slot] = 0;
+  lengths[slot] =
+      static_cast<std::uint8_t>(std::max(1, std::min(length, MAX_LENGTH)));
+}
+
+void TrailArena::push(std::uint32_t slot, sf::Vector2f point) {
+  std::size_t base = static_cast<std::size_t>(slot) * MAX_LENGTH;
+  int length = lengths[slot];
+  if (counts[slot] < length) {
+    int index = heads[slot] + counts[slot];
+    if (index >= length)
+      index -= length;
+    points[base + index] = point;
+    counts[slot]++;
+  } else {
+    // Буфер полон: новая точка вытесняет самую старую
+    points[base + heads[slot]] = point;
+    heads[slot] = static_cast<std::uint8_t>((heads[slot] + 1) % length);
+  }
+}
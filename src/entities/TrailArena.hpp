@@ -0,0 +1,32 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// Следы всех снарядов в одном непрерывном массиве: у каждого слота пула
+// кольцевой буфер фиксированной емкости MAX_LENGTH. Запись точки не
+// выделяет память, а точки одного следа лежат подряд.
+class TrailArena {
+public:
+  static constexpr int MAX_LENGTH = 32;
+
+  void resize(std::size_t slots);
+  // Очищает след слота и задает его длину (не больше MAX_LENGTH)
+  void reset(std::uint32_t slot, int length);
+  void push(std::uint32_t slot, sf::Vector2f point);
+
+  int size(std::uint32_t slot) const { return counts[slot]; }
+  // i = 0 — самая старая точка
+  sf::Vector2f at(std::uint32_t slot, int i) const {
+    int index = heads[slot] + i;
+    if (index >= lengths[slot])
+      index -= lengths[slot];
+    return points[static_cast<std::size_t>(slot) * MAX_LENGTH + index];
+  }
+
+private:
+  std::vector<sf::Vector2f> points;
+  std::vector<std::uint8_t> heads;
+  std::vector<std::uint8_t> counts;
+  std::vector<std::uint8_t> lengths;
+};
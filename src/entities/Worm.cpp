@@ -2,30 +2,21 @@
 #include "../utils/GameTypes.hpp"
 #include <algorithm>
 
-Worm::Worm(float x, float y, sf::Color color, int team)
-    : teamColor(color), teamId(team) {
+Worm::Worm(float x, float y, int team) : teamId(team) {
   position = sf::Vector2f(x, y);
+  previousPosition = position;
   velocity = sf::Vector2f(0, 0);
   health = 100;
   maxHealth = 100;
-  shape.setRadius(GameTypes::WORM_RADIUS);
-  shape.setFillColor(color);
-  shape.setOutlineThickness(2);
-  shape.setOutlineColor(sf::Color::Black);
   isActive = true;
   isGrounded = false;
   canJump = true;
   jumpCooldown = 0.0f;
   isMyTurn = false;
-
-  // Настройка полоски здоровья
-  healthBarBg.setSize(sf::Vector2f(30, 4));
-  healthBarBg.setFillColor(sf::Color::Red);
-  healthBar.setSize(sf::Vector2f(30, 4));
-  healthBar.setFillColor(sf::Color::Green);
 }
 
 void Worm::update(float deltaTime, TerrainManager &terrain) {
+  previousPosition = position;
   if (!isActive)
     return;
 
@@ -67,20 +58,22 @@ void Worm::update(float deltaTime, TerrainManager &terrain) {
   // Применяем трение только по X
   velocity.x *= 0.85f;
 
-  // Проверяем границы экрана
+  // Проверяем границы карты
   if (position.x < GameTypes::WORM_RADIUS) {
     position.x = GameTypes::WORM_RADIUS;
     velocity.x = 0;
   }
-  if (position.x > GameTypes::WINDOW_WIDTH - GameTypes::WORM_RADIUS) {
-    position.x = GameTypes::WINDOW_WIDTH - GameTypes::WORM_RADIUS;
+  float rightEdge = terrain.getWidth() - GameTypes::WORM_RADIUS;
+  if (position.x > rightEdge) {
+    position.x = rightEdge;
     velocity.x = 0;
   }
-  if (position.y > 650) {
+  if (position.y > terrain.getHeight() + 50) {
     takeDamage(20);
     // Возвращаем червяка на поверхность
     int groundLevel = terrain.findGroundLevel(static_cast<int>(position.x));
     position.y = groundLevel - 20;
+    previousPosition = position;
     velocity.y = 0;
   }
 }
@@ -113,46 +106,4 @@ void Worm::takeDamage(int damage) {
   }
 }
 
-void Worm::draw(sf::RenderWindow &window) {
-  if (!isActive) {
-    sf::Color deadColor = teamColor;
-    deadColor.a = 100;
-    shape.setFillColor(deadColor);
-  } else {
-    shape.setFillColor(teamColor);
-
-    // Подсвечиваем активного игрока
-    if (isMyTurn) {
-      shape.setOutlineThickness(4);
-      shape.setOutlineColor(sf::Color::White);
-    } else {
-      shape.setOutlineThickness(2);
-      shape.setOutlineColor(sf::Color::Black);
-    }
-  }
-
-  shape.setPosition(position.x - GameTypes::WORM_RADIUS,
-                    position.y - GameTypes::WORM_RADIUS);
-  window.draw(shape);
-
-  if (isActive) {
-    // Рисуем полоску здоровья
-    healthBarBg.setPosition(position.x - 15, position.y - 25);
-    healthBar.setPosition(position.x - 15, position.y - 25);
-    float healthPercent = static_cast<float>(health) / maxHealth;
-    healthBar.setSize(sf::Vector2f(30 * healthPercent, 4));
-
-    if (healthPercent > 0.6f) {
-      healthBar.setFillColor(sf::Color::Green);
-    } else if (healthPercent > 0.3f) {
-      healthBar.setFillColor(sf::Color::Yellow);
-    } else {
-      healthBar.setFillColor(sf::Color::Red);
-    }
-
-    window.draw(healthBarBg);
-    window.draw(healthBar);
-  }
-}
-
 sf::Vector2f Worm::getCenter() const { return position; }
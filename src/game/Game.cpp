@@ -2,64 +2,69 @@
 #include "../utils/GameTypes.hpp"
 #include "../utils/MathUtils.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+// Скорость, с которой камера догоняет цель: доля пути в секунду
+constexpr float CAMERA_FOLLOW_RATE = 6.0f;
+
+// Камера не заглядывает за край карты; карта меньше окна стоит по центру
+float clampCameraAxis(float center, float viewSize, float worldSize) {
+  if (worldSize <= viewSize)
+    return worldSize / 2.0f;
+  return std::max(viewSize / 2.0f,
+                  std::min(center, worldSize - viewSize / 2.0f));
+}
+
+// Первый матч пишется в path, следующие — в "match-2.wrpl" и т.д.
+std::string numberedPath(const std::string &path, int match) {
+  if (match == 0)
+    return path;
+  std::size_t slash = path.find_last_of('/');
+  std::size_t dot = path.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    dot = path.size();
+  return path.substr(0, dot) + "-" + std::to_string(match + 1) +
+         path.substr(dot);
+}
+} // namespace
 
-Game::Game()
+Game::Game(BattleConfig battle, sf::Vector2i worldSize,
+           std::shared_ptr<const MapFile> map, float tickRate,
+           int catchUpTicks)
     : window(sf::VideoMode(GameTypes::WINDOW_WIDTH, GameTypes::WINDOW_HEIGHT),
              "Enhanced Wormix Game"),
-      terrain(GameTypes::WINDOW_WIDTH, GameTypes::WINDOW_HEIGHT),
-      currentPlayer(0), aimPower(0), gameStarted(true), gameEnded(false),
-      winner(-1), turnTimer(0.0f), canShoot(true),
-      currentWeapon(GameTypes::WeaponType::BAZOOKA),
-      weaponIndex(0) { // Добавить инициализацию
+      // С картой из файла размер мира задает файл
+      simulation(map ? Simulation(map, std::random_device{}(), battle)
+                     : Simulation(worldSize.x, worldSize.y,
+                                  std::random_device{}(), battle, &aiPool)),
+      seedSource(simulation.getSeed()), aimSolver(&aiPool),
+      bot(ScriptedShooter::Mode::SEARCH,
+          RandomStream(simulation.getSeed()).split(RandomStreams::SHOOTERS),
+          &aimSolver),
+      botsEnabled(false),
+      camera(sf::FloatRect(0, 0, GameTypes::WINDOW_WIDTH,
+                           GameTypes::WINDOW_HEIGHT)),
+      aimDirty(false),
+      tickDuration(1.0f / tickRate), maxCatchUpTicks(catchUpTicks),
+      accumulator(0.0f), renderAlpha(0.0f), recordedMatches(0),
+      playbackSpeed(1.0f), playbackDone(false), netStalled(false),
+      netDesync(false), profilerVisible(false) {
 
   // Инициализируем массив нажатых клавиш
   for (int i = 0; i < sf::Keyboard::KeyCount; i++) {
     keysPressed[i] = false;
   }
 
-  // Создаем червяков с ID команд
-  worms.push_back(Worm(150, 200, sf::Color::Green, 0));
-  worms.push_back(Worm(650, 200, sf::Color::Blue, 1));
-
-  // Размещаем червяков на земле
-  for (auto &worm : worms) {
-    int groundLevel =
-        terrain.findGroundLevel(static_cast<int>(worm.position.x));
-    worm.position.y = groundLevel - 20;
-  }
-
-  // Устанавливаем первого игрока как активного
-  worms[currentPlayer].isMyTurn = true;
-
   window.setFramerateLimit(60);
-}
-
-void Game::calculateTrajectory() {
-  trajectoryPoints.clear();
-
-  if (!worms[currentPlayer].isMyTurn)
-    return;
-
-  sf::Vector2f wormCenter = worms[currentPlayer].getCenter();
-  sf::Vector2f startPos = wormCenter + aimDirection * 25.0f;
-  sf::Vector2f vel = aimDirection * (400.0f + aimPower * 3.0f);
-  float dt = 0.05f;
-
-  for (int i = 0; i < 100; i++) {
-    trajectoryPoints.push_back(startPos);
-    vel.y += GameTypes::PROJECTILE_GRAVITY * dt;
-    startPos += vel * dt;
-
-    if (terrain.isColliding(static_cast<int>(startPos.x),
-                            static_cast<int>(startPos.y)) ||
-        startPos.y > GameTypes::WINDOW_HEIGHT || startPos.x < 0 ||
-        startPos.x > GameTypes::WINDOW_WIDTH) {
-      break;
-    }
-  }
+  updateCamera(1.0f);
 }
 
 void Game::handleEvents() {
+  PROFILE_ZONE("events");
   sf::Event event;
   while (window.pollEvent(event)) {
     if (event.type == sf::Event::Closed) {
@@ -76,288 +81,425 @@ void Game::handleEvents() {
     }
 
     if (event.type == sf::Event::MouseButtonPressed) {
-      if (event.mouseButton.button == sf::Mouse::Left && canShoot &&
-          worms[currentPlayer].isMyTurn) {
-        shoot();
+      if (event.mouseButton.button == sf::Mouse::Left) {
+        pendingInput.shoot = true;
       }
     }
 
+    // Мышь с высокой частотой опроса шлет много событий за кадр:
+    // прицел пересчитываем один раз после разбора очереди
     if (event.type == sf::Event::MouseMoved) {
-      updateAim();
+      aimDirty = true;
     }
   }
+
+  if (aimDirty) {
+    aimDirty = false;
+    updateAim();
+  }
 }
 
 void Game::handleKeyPress(sf::Keyboard::Key key) {
-  if (!gameStarted || gameEnded) {
-    if (key == sf::Keyboard::R && gameEnded) {
-      restartGame();
-    }
+  if (key == sf::Keyboard::F3 && Profiler::ENABLED) {
+    profilerVisible = !profilerVisible;
+    profile = Profiler::summary();
     return;
   }
-
-  Worm &activeWorm = worms[currentPlayer];
-  if (!activeWorm.isActive || !activeWorm.isMyTurn)
+  if (simulation.isGameOver()) {
+    // Новый матч по сети пришлось бы согласовывать с остальными
+    if (key == sf::Keyboard::R && !playback && !net)
+      startMatch(seedSource.nextU64());
+    return;
+  }
+  if (playback)
     return;
 
+  // Действия копятся до ближайшего тика и проверяются уже симуляцией
   switch (key) {
   case sf::Keyboard::Num1:
-    currentWeapon = GameTypes::WeaponType::BAZOOKA;
+    pendingInput.selectWeapon = true;
+    pendingInput.weapon = GameTypes::WeaponType::BAZOOKA;
     break;
   case sf::Keyboard::Num2:
-    currentWeapon = GameTypes::WeaponType::SNIPER_RIFLE;
+    pendingInput.selectWeapon = true;
+    pendingInput.weapon = GameTypes::WeaponType::SNIPER_RIFLE;
     break;
   case sf::Keyboard::Num3:
-    currentWeapon = GameTypes::WeaponType::FRAG_GRENADE;
+    pendingInput.selectWeapon = true;
+    pendingInput.weapon = GameTypes::WeaponType::FRAG_GRENADE;
     break;
   case sf::Keyboard::Space:
-    if (canShoot) {
-      shoot();
-    }
+    pendingInput.shoot = true;
     break;
   case sf::Keyboard::W:
-  case sf::Keyboard::Up: {
-    sf::Vector2f jumpDir = aimDirection;
-    jumpDir.y = std::min(jumpDir.y, -0.3f);
-    activeWorm.jump(jumpDir);
-  } break;
+  case sf::Keyboard::Up:
+    pendingInput.jump = true;
+    break;
+  case sf::Keyboard::B:
+    // За все команды, кроме первой, играет компьютер
+    if (!net)
+      botsEnabled = !botsEnabled;
+    break;
   default:
     // Обработка остальных клавиш
     break;
   }
 }
-void Game::shoot() {
-  if (!canShoot || !gameStarted || gameEnded)
-    return;
 
-  Worm &activeWorm = worms[currentPlayer];
-  if (!activeWorm.isActive || !activeWorm.isMyTurn)
-    return;
+void Game::startMatch(std::uint64_t seed) {
+  finishRecording();
+  simulation.restart(seed);
+  bot = ScriptedShooter(
+      ScriptedShooter::Mode::SEARCH,
+      RandomStream(simulation.getSeed()).split(RandomStreams::SHOOTERS),
+      &aimSolver);
+  pendingInput = PlayerInput();
+  trajectory.clear();
+  accumulator = 0.0f;
+  updateCamera(1.0f);
+  if (!recordPath.empty())
+    recorder.reset(new ReplayRecorder(replayHeader()));
+}
+
+ReplayHeader Game::replayHeader() const {
+  ReplayHeader header;
+  header.seed = simulation.getSeed();
+  header.worldWidth = simulation.getTerrain().getWidth();
+  header.worldHeight = simulation.getTerrain().getHeight();
+  header.battle = simulation.getBattle();
+  header.tickDuration = tickDuration;
+  if (simulation.getTerrain().getSource())
+    header.mapPath = simulation.getTerrain().getSource()->getPath();
+  return header;
+}
 
-  float basePower = 400.0f;
+void Game::recordTo(const std::string &path) {
+  recordPath = path;
+  recorder.reset(new ReplayRecorder(replayHeader()));
+}
 
-  // Настройки мощности для разных типов оружия
-  switch (currentWeapon) {
-  case GameTypes::WeaponType::SNIPER_RIFLE:
-    basePower = 800.0f; // Высокая скорость
-    break;
-  case GameTypes::WeaponType::FRAG_GRENADE:
-    basePower = 300.0f; // Меньшая скорость
-    break;
-  default: // BAZOOKA
-    basePower = 400.0f;
-    break;
+void Game::finishRecording() {
+  if (!recorder || recorder->getTicks() == 0)
+    return;
+  std::string path = numberedPath(recordPath, recordedMatches++);
+  if (recorder->save(path, simulation.stateHash())) {
+    std::printf("recorded %d ticks to %s\n", recorder->getTicks(),
+                path.c_str());
+  } else {
+    std::perror(path.c_str());
   }
+  recorder.reset();
+}
 
-  float power = basePower + aimPower * 3.0f;
-  sf::Vector2f spawnPos = activeWorm.getCenter() + aimDirection * 25.0f;
+void Game::playReplay(std::unique_ptr<ReplayReader> replay, float speed) {
+  const ReplayHeader &header = replay->getHeader();
+  tickDuration = header.tickDuration;
+  playbackSpeed = speed;
+  playbackDone = false;
+  recordPath.clear();
+  startMatch(header.seed);
+  playback = std::move(replay);
+}
 
-  projectiles.push_back(
-      Projectile(spawnPos.x, spawnPos.y, aimDirection.x * power,
-                 aimDirection.y * power, activeWorm.teamId, currentWeapon));
+void Game::playOnline(std::unique_ptr<LockstepSession> session,
+                      std::uint64_t seed) {
+  botsEnabled = false;
+  startMatch(seed);
+  net = std::move(session);
+  netClock.restart();
+}
 
-  canShoot = false;
-  activeWorm.isMyTurn = false;
-  switchToNextPlayer();
-  trajectoryPoints.clear();
+void Game::broadcastTo(std::unique_ptr<SpectatorServer> server) {
+  spectators = std::move(server);
 }
 
-void Game::handleContinuousInput() {
-  if (!gameStarted || gameEnded)
-    return;
+void Game::profileTo(const std::string &path) {
+  profilePath = path;
+  bool trace = Profiler::isTracePath(path);
+  Profiler::keepHistory(!trace, trace);
+}
 
-  Worm &activeWorm = worms[currentPlayer];
-  if (!activeWorm.isActive || !activeWorm.isMyTurn)
-    return;
+double Game::netTime() const {
+  return netClock.getElapsedTime().asMicroseconds() / 1e6;
+}
 
-  if (keysPressed[sf::Keyboard::A] || keysPressed[sf::Keyboard::Left]) {
-    activeWorm.move(-1.0f);
-  }
-  if (keysPressed[sf::Keyboard::D] || keysPressed[sf::Keyboard::Right]) {
-    activeWorm.move(1.0f);
+void Game::finishPlayback() {
+  playbackDone = true;
+  if (playback->getTicksRead() < playback->getTicks()) {
+    std::printf("replay: input %s at tick %d of %d\n",
+                playback->isInputCorrupt() ? "is corrupt" : "ends early",
+                playback->getTicksRead(), playback->getTicks());
+    return;
   }
+  bool match = simulation.stateHash() == playback->getFinalHash();
+  std::printf("replay: %d ticks, end state %s\n", playback->getTicks(),
+              match ? "matches the recording" : "DIFFERS from the recording");
 }
 
 void Game::updateAim() {
-  if (!gameStarted || gameEnded || !worms[currentPlayer].isMyTurn)
+  if (playback || simulation.isGameOver() ||
+      !simulation.getActiveWorm().isMyTurn || !isLocalTurn())
     return;
 
-  sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-  sf::Vector2f wormPos = worms[currentPlayer].getCenter();
+  // Курсор переводим в координаты мира через камеру
+  sf::Vector2f mousePos =
+      window.mapPixelToCoords(sf::Mouse::getPosition(window), camera);
+  sf::Vector2f wormPos = simulation.getActiveWorm().getCenter();
 
-  aimDirection = sf::Vector2f(mousePos.x - wormPos.x, mousePos.y - wormPos.y);
-  float length = MathUtils::length(aimDirection);
+  sf::Vector2f aim = mousePos - wormPos;
+  float length = MathUtils::length(aim);
 
   if (length > 0) {
-    aimDirection = MathUtils::normalize(aimDirection);
-    aimPower = std::min(length / 3.0f, 100.0f);
-    calculateTrajectory();
+    pendingInput.aimDirection = MathUtils::normalize(aim);
+    pendingInput.aimPower = std::min(length / 3.0f, 100.0f);
   }
 }
 
-void Game::switchToNextPlayer() {
-  int nextPlayer = currentPlayer;
-  do {
-    nextPlayer = (nextPlayer + 1) % worms.size();
-  } while (!worms[nextPlayer].isActive && getActiveWormsCount() > 1);
-
-  currentPlayer = nextPlayer;
-  worms[currentPlayer].isMyTurn = true;
-  canShoot = true;
-  turnTimer = 0.0f;
-}
-
-int Game::getActiveWormsCount() {
-  int count = 0;
-  for (const auto &worm : worms) {
-    if (worm.isActive)
-      count++;
+void Game::updateCamera(float blend) {
+  sf::Vector2f target = simulation.getActiveWorm().getCenter();
+  const ProjectilePool &projectiles = simulation.getProjectiles();
+  for (std::uint32_t slot : projectiles.getLiveSlots()) {
+    if (projectiles.activeFlags[slot]) {
+      target = projectiles.positions[slot];
+      break;
+    }
   }
-  return count;
-}
 
-void Game::restartGame() {
-  worms.clear();
-  projectiles.clear();
-  terrain = TerrainManager(GameTypes::WINDOW_WIDTH, GameTypes::WINDOW_HEIGHT);
-
-  worms.push_back(Worm(150, 200, sf::Color::Green, 0));
-  worms.push_back(Worm(650, 200, sf::Color::Blue, 1));
-
-  for (auto &worm : worms) {
-    int groundLevel =
-        terrain.findGroundLevel(static_cast<int>(worm.position.x));
-    worm.position.y = groundLevel - 20;
+  const TerrainManager &terrain = simulation.getTerrain();
+  sf::Vector2f size = camera.getSize();
+  sf::Vector2f center = camera.getCenter();
+  center += (target - center) * std::min(blend, 1.0f);
+  center.x = clampCameraAxis(center.x, size.x, terrain.getWidth());
+  center.y = clampCameraAxis(center.y, size.y, terrain.getHeight());
+  if (center != camera.getCenter()) {
+    camera.setCenter(center);
+    // Под неподвижным курсором оказалась другая точка мира
+    aimDirty = true;
   }
-
-  currentPlayer = 0;
-  worms[currentPlayer].isMyTurn = true;
-  gameStarted = true;
-  gameEnded = false;
-  winner = -1;
-  canShoot = true;
-  turnTimer = 0.0f;
 }
 
 void Game::update() {
-  if (!gameStarted || gameEnded)
+  PROFILE_ZONE("update");
+  float frameTime = clock.restart().asSeconds();
+  // После конца матча сеть тоже обслуживается: наш ввод и подтверждения
+  // нужны отстающим участникам
+  if (net) {
+    PROFILE_ZONE("net");
+    net->receivePackets(netTime());
+  }
+  if (simulation.isGameOver() || playbackDone || netDesync) {
+    if (net)
+      net->sendPackets(netTime());
+    if (spectators)
+      spectators->poll(simulation);
     return;
-
-  float deltaTime = clock.restart().asSeconds();
-  turnTimer += deltaTime;
-
-  handleContinuousInput();
-
-  for (auto &worm : worms) {
-    worm.update(deltaTime, terrain);
   }
 
-  for (auto &projectile : projectiles) {
-    projectile.update(deltaTime, terrain);
-
-    for (auto &worm : worms) {
-      if (projectile.checkWormCollision(worm)) {
-        sf::Vector2f explosionPos = projectile.getPosition();
-        for (auto &targetWorm : worms) {
-          float distanceLength =
-              MathUtils::distance(explosionPos, targetWorm.getCenter());
-
-          if (distanceLength < projectile.explosionRadius) {
-            int damage = static_cast<int>(
-                projectile.damage *
-                (1.0f - distanceLength / projectile.explosionRadius));
-            if (targetWorm.teamId == projectile.shooterTeam) {
-              damage = damage / 3;
-            }
-
-            targetWorm.takeDamage(damage);
-
-            if (distanceLength > 0) {
-              sf::Vector2f knockback = (targetWorm.getCenter() - explosionPos);
-              knockback = MathUtils::normalize(knockback);
-              targetWorm.velocity += knockback * 150.0f;
-            }
-          }
-        }
-
-        projectile.explode(terrain);
+  // Копим реальное время и отрабатываем его целыми тиками. Если машина не
+  // успевает, ограничиваем догон и отбрасываем остаток, чтобы не уйти в
+  // спираль все более долгих кадров. Запись ускоряет и время, и предел.
+  accumulator += frameTime * playbackSpeed;
+  int catchUpLimit = std::max(
+      1, static_cast<int>(std::ceil(maxCatchUpTicks * playbackSpeed)));
+  int ticks = 0;
+  netStalled = false;
+  while (accumulator >= tickDuration && ticks < catchUpLimit) {
+    PlayerInput input;
+    if (net) {
+      if (!net->ready()) {
+        netStalled = true;
         break;
       }
-    }
-  }
-
-  projectiles.erase(
-      std::remove_if(projectiles.begin(), projectiles.end(),
-                     [](const Projectile &p) { return !p.isActive; }),
-      projectiles.end());
-
-  int activeCount = getActiveWormsCount();
-  if (activeCount <= 1) {
-    gameEnded = true;
-    for (size_t i = 0; i < worms.size(); i++) {
-      if (worms[i].isActive) {
-        winner = i;
+      input = net->inputOf(net->ownerOf(simulation.getActiveWorm().teamId));
+    } else if (playback) {
+      // Прицел из записи рисуется так же, как прицел игрока
+      if (!playback->next(pendingInput)) {
+        finishPlayback();
         break;
       }
+      input = pendingInput;
+    } else if (isBotTurn()) {
+      PROFILE_ZONE("bot");
+      input = bot.decide(simulation);
+    } else {
+      input = localInput();
+    }
+
+    if (recorder)
+      recorder->record(input);
+    simulation.step(input, tickDuration);
+    if (spectators) {
+      PROFILE_ZONE("spectators");
+      spectators->broadcast(simulation);
+    }
+
+    // Свой ввод уходит участникам и исполнится через inputDelay тиков
+    if (net)
+      net->advance(isLocalTurn() ? localInput() : PlayerInput(),
+                   simulation.checksum(), netTime());
+
+    // Разовые действия срабатывают только в одном тике
+    pendingInput.jump = false;
+    pendingInput.shoot = false;
+    pendingInput.selectWeapon = false;
+
+    accumulator -= tickDuration;
+    ticks++;
+    if (simulation.isGameOver())
+      break;
+  }
+  // Пока ждем сеть, время не копится: после простоя не нужен рывок
+  if (accumulator >= tickDuration)
+    accumulator = netStalled ? tickDuration : 0.0f;
+
+  if (net) {
+    PROFILE_ZONE("net");
+    net->sendPackets(netTime());
+    if (net->getDesyncTick() >= 0) {
+      netDesync = true;
+      std::printf("network: game state diverged after tick %d, "
+                  "match stopped\n",
+                  net->getDesyncTick());
     }
   }
+
+  if (spectators) {
+    PROFILE_ZONE("spectators");
+    spectators->poll(simulation);
+  }
+
+  if (simulation.isGameOver())
+    finishRecording();
+  if (playback && !playbackDone &&
+      (simulation.isGameOver() ||
+       playback->getTicksRead() == playback->getTicks()))
+    finishPlayback();
+
+  renderAlpha = accumulator / tickDuration;
+  updateCamera(frameTime * CAMERA_FOLLOW_RATE);
+
+  // Из кеша, если червяк, прицел и местность вдоль пути не менялись
+  if (!isLocalTurn()) {
+    trajectory.clear();
+  } else {
+    PROFILE_ZONE("trajectory");
+    trajectory.update(simulation, pendingInput);
+  }
 }
 
-void Game::render() {
-  window.clear(sf::Color(135, 206, 235));
+bool Game::isBotTurn() const {
+  return botsEnabled && simulation.getActiveWorm().teamId != 0;
+}
 
-  terrain.draw(window);
+bool Game::isLocalTurn() const {
+  if (net)
+    return net->ownerOf(simulation.getActiveWorm().teamId) ==
+           net->getLocalPeer();
+  return !isBotTurn();
+}
 
-  for (auto &worm : worms) {
-    worm.draw(window);
+PlayerInput Game::localInput() {
+  pendingInput.move = 0.0f;
+  if (keysPressed[sf::Keyboard::A] || keysPressed[sf::Keyboard::Left]) {
+    pendingInput.move -= 1.0f;
   }
-
-  for (auto &projectile : projectiles) {
-    projectile.draw(window);
+  if (keysPressed[sf::Keyboard::D] || keysPressed[sf::Keyboard::Right]) {
+    pendingInput.move += 1.0f;
   }
+  return pendingInput;
+}
 
-  if (worms[currentPlayer].isMyTurn && !trajectoryPoints.empty()) {
+void Game::render() {
+  PROFILE_ZONE("render");
+  window.clear(sf::Color(135, 206, 235));
+  batch.begin();
+
+  // Мир рисуется через камеру, панель и затемнение — в координатах окна
+  window.setView(camera);
+
+  worldRenderer.draw(window, batch, simulation, renderAlpha);
+
+  const Worm &activeWorm = simulation.getActiveWorm();
+  const std::vector<sf::Vector2f> &trajectoryPoints = trajectory.getPoints();
+  if (activeWorm.isMyTurn && !trajectoryPoints.empty()) {
     for (size_t i = 1; i < trajectoryPoints.size(); i++) {
-      sf::CircleShape point(2);
-      point.setPosition(trajectoryPoints[i].x - 2, trajectoryPoints[i].y - 2);
       sf::Color pointColor = sf::Color::White;
       pointColor.a = static_cast<sf::Uint8>(
           255 * (1.0f - static_cast<float>(i) / trajectoryPoints.size()));
-      point.setFillColor(pointColor);
-      window.draw(point);
+      batch.addCircle(trajectoryPoints[i], 2, pointColor);
     }
   }
 
-  if (gameStarted && !gameEnded && worms[currentPlayer].isMyTurn) {
-    sf::Vector2f wormCenter = worms[currentPlayer].getCenter();
+  if (!simulation.isGameOver() && activeWorm.isMyTurn && isLocalTurn()) {
+    sf::Vector2f aimDirection = pendingInput.aimDirection;
+    float aimPower = pendingInput.aimPower;
+    sf::Vector2f wormCenter = activeWorm.getCenter();
     sf::Vector2f aimEnd = wormCenter + aimDirection * (50.0f + aimPower);
 
-    sf::Vertex line[] = {sf::Vertex(wormCenter, sf::Color::White),
-                         sf::Vertex(aimEnd, sf::Color::Red)};
-    window.draw(line, 2, sf::Lines);
+    batch.addLine(wormCenter, aimEnd, sf::Color::White, sf::Color::Red);
 
-    sf::CircleShape powerIndicator(3 + aimPower / 10);
-    powerIndicator.setPosition(aimEnd.x - powerIndicator.getRadius(),
-                               aimEnd.y - powerIndicator.getRadius());
-    powerIndicator.setFillColor(
+    batch.addCircle(
+        aimEnd, 3 + aimPower / 10,
         sf::Color(255, 255 - static_cast<int>(aimPower * 2.55f), 0));
-    window.draw(powerIndicator);
   }
 
-  if (gameEnded) {
-    sf::RectangleShape overlay(
-        sf::Vector2f(GameTypes::WINDOW_WIDTH, GameTypes::WINDOW_HEIGHT));
-    overlay.setFillColor(sf::Color(0, 0, 0, 150));
-    window.draw(overlay);
+  batch.flush(window);
+
+  window.setView(window.getDefaultView());
+  worldRenderer.drawHud(batch, simulation);
+  if (simulation.isGameOver()) {
+    batch.addRect(
+        sf::Vector2f(0, 0),
+        sf::Vector2f(GameTypes::WINDOW_WIDTH, GameTypes::WINDOW_HEIGHT),
+        sf::Color(0, 0, 0, 150));
+  }
+  if (profilerVisible)
+    profilerOverlay.draw(batch, profile);
+
+  batch.flush(window);
+  {
+    // Здесь же ожидание ограничителя кадров
+    PROFILE_ZONE("display");
+    window.display();
   }
 
-  window.display();
+  if (statsClock.getElapsedTime().asSeconds() >= 1.0f) {
+    statsClock.restart();
+    const BatchRenderer::FrameStats &stats = batch.getStats();
+    std::string title = "Enhanced Wormix Game - " +
+                        std::to_string(stats.drawCalls) + " draw calls, " +
+                        std::to_string(stats.vertices) + " vertices";
+    if (net) {
+      const LockstepStats &netStats = net->getStats();
+      title += ", tick " + std::to_string(net->getTick()) + ", ack " +
+               std::to_string(static_cast<int>(netStats.roundTrip * 1000)) +
+               " ms, suggested delay " +
+               std::to_string(netStats.suggestedDelay) +
+               (netDesync ? ", DESYNC" : netStalled ? ", waiting" : "");
+    }
+    if (profilerVisible) {
+      profile = Profiler::summary();
+      title += " - " + ProfilerOverlay::describe(profile);
+    }
+    window.setTitle(title);
+  }
 }
 
 void Game::run() {
+  Profiler::recordThisThread();
   while (window.isOpen()) {
     handleEvents();
     update();
     render();
+    PROFILE_FRAME();
+  }
+  // Матч прерван закрытием окна: запись сохраняется как есть
+  finishRecording();
+
+  if (!profilePath.empty()) {
+    if (Profiler::write(profilePath))
+      std::printf("profiler: frames written to %s\n", profilePath.c_str());
+    else
+      std::perror(profilePath.c_str());
   }
 }
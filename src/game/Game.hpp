@@ -1,46 +1,120 @@
 #pragma once
-#include "../entities/Projectile.hpp"
-#include "../entities/Worm.hpp"
-#include "../terrain/TerrainManager.hpp"
+#include "../ai/AimSolver.hpp"
+#include "../ai/ScriptedShooter.hpp"
+#include "../net/Lockstep.hpp"
+#include "../net/SpectatorServer.hpp"
+#include "../render/BatchRenderer.hpp"
+#include "../render/ProfilerOverlay.hpp"
+#include "../render/WorldRenderer.hpp"
 #include "../utils/GameTypes.hpp"
+#include "../utils/Profiler.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "PlayerInput.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "TrajectoryPreview.hpp"
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
+// Окно, ввод и цикл кадров. Правила игры живут в Simulation, отрисовка
+// мира — в WorldRenderer.
 class Game {
 private:
   sf::RenderWindow window;
-  TerrainManager terrain;
-  std::vector<Worm> worms;
-  std::vector<Projectile> projectiles;
-  int currentPlayer;
+  // Пул наведения ботов; до первого хода им же генерируются карты
+  ThreadPool aiPool;
+  Simulation simulation;
+  RandomStream seedSource; // seed для каждой новой карты
+  AimSolver aimSolver;
+  ScriptedShooter bot;
+  bool botsEnabled; // все команды, кроме первой, играет компьютер
+  WorldRenderer worldRenderer;
+  BatchRenderer batch;
+  sf::View camera; // следит за снарядом в полете или активным червяком
+  sf::Clock statsClock; // раз в секунду выводим статистику отрисовки
   sf::Clock clock;
-  sf::Vector2f aimDirection;
-  float aimPower;
-  bool gameStarted;
-  bool gameEnded;
-  int winner;
-  GameTypes::WeaponType currentWeapon;
-  int weaponIndex;
-  std::vector<sf::Vector2f> trajectoryPoints;
+  PlayerInput pendingInput; // ввод, накопленный до следующего тика
+  TrajectoryPreview trajectory;
+  bool aimDirty; // мышь или камера двигались с прошлого кадра
   bool keysPressed[sf::Keyboard::KeyCount];
-  float turnTimer;
-  bool canShoot;
+
+  // Фиксированный шаг симуляции
+  float tickDuration;
+  int maxCatchUpTicks;
+  float accumulator;
+  float renderAlpha; // доля шага между двумя последними состояниями
+
+  // Запись матчей: каждый новый матч пишется в свой файл
+  std::string recordPath;
+  int recordedMatches;
+  std::unique_ptr<ReplayRecorder> recorder;
+
+  // Просмотр записи: ввод берется из файла, время идет в playbackSpeed раз
+  // быстрее, ввод с клавиатуры и мыши не принимается
+  std::unique_ptr<ReplayReader> playback;
+  float playbackSpeed;
+  bool playbackDone;
+
+  // Игра по сети: тики идут, только когда пришел ввод всех участников,
+  // клавиатура управляет лишь своими командами
+  std::unique_ptr<LockstepSession> net;
+  sf::Clock netClock;
+  bool netStalled; // в последнем кадре ждали ввод по сети
+  bool netDesync;  // состояния разошлись, матч остановлен
+
+  // Трансляция зрителям: каждый тик уходит всем подключенным
+  std::unique_ptr<SpectatorServer> spectators;
+
+  // Профилировщик (сборка с PROFILE=1): панель по F3 и запись на выходе
+  ProfilerOverlay profilerOverlay;
+  std::vector<Profiler::ZoneSummary> profile; // обновляется раз в секунду
+  bool profilerVisible;
+  std::string profilePath;
 
 public:
-  Game();
+  explicit Game(BattleConfig battle = BattleConfig(),
+                sf::Vector2i worldSize = sf::Vector2i(GameTypes::WORLD_WIDTH,
+                                                      GameTypes::WORLD_HEIGHT),
+                std::shared_ptr<const MapFile> map = nullptr,
+                float tickRate = GameTypes::SIM_TICK_RATE,
+                int maxCatchUpTicks = GameTypes::MAX_CATCH_UP_TICKS);
+
+  // Писать ввод каждого тика в path (следующие матчи — path-2 и т.д.)
+  void recordTo(const std::string &path);
+  // Показать запись вместо игры. Размер мира, карту и состав матча
+  // вызывающий берет из заголовка записи.
+  void playReplay(std::unique_ptr<ReplayReader> replay, float speed);
+  // Матч по сети. seed, мир и состав матча у всех участников должны быть
+  // одинаковыми; иначе расхождение заметят контрольные суммы.
+  void playOnline(std::unique_ptr<LockstepSession> session,
+                  std::uint64_t seed);
+  // Транслировать матчи зрителям этого сервера
+  void broadcastTo(std::unique_ptr<SpectatorServer> server);
+  // Записать профиль кадров при выходе: .json — Chrome trace, иначе CSV
+  void profileTo(const std::string &path);
 
   void run();
 
 private:
-  void calculateTrajectory();
+  void startMatch(std::uint64_t seed);
+  ReplayHeader replayHeader() const;
+  void finishRecording();
+  void finishPlayback();
   void handleEvents();
   void handleKeyPress(sf::Keyboard::Key key);
-  void handleContinuousInput();
+  bool isBotTurn() const;
+  // Ходит червяк, которым управляет этот игрок
+  bool isLocalTurn() const;
+  // Ввод с клавиатуры и мыши на очередной тик
+  PlayerInput localInput();
+  double netTime() const;
   void updateAim();
-  void shoot();
-  void switchToNextPlayer();
-  int getActiveWormsCount();
-  void restartGame();
+  // blend — доля пути до цели, проходимая за вызов; 1 — сразу в цель
+  void updateCamera(float blend);
   void update();
   void render();
 };
@@ -0,0 +1,109 @@
+#include "InputCodec.hpp"
+#include <cstring>
+
+namespace {
+enum InputFlags : std::uint8_t {
+  AIM = 1,
+  MOVE = 2,
+  JUMP = 4,
+  SHOOT = 8,
+  WEAPON = 16,
+};
+
+// Сравнение по битам: -0.0 и 0.0 для воспроизведения — разные числа
+bool sameBits(float a, float b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+} // namespace
+
+InputEncoder::InputEncoder(const PlayerInput &previous)
+    : previous(previous), idleTicks(0) {}
+
+void InputEncoder::flush(ByteWriter &out) {
+  if (idleTicks == 0)
+    return;
+  out.u8(0);
+  out.varint(idleTicks);
+  idleTicks = 0;
+}
+
+void InputEncoder::add(ByteWriter &out, const PlayerInput &input) {
+  std::uint8_t flags = 0;
+  if (!sameBits(input.aimDirection.x, previous.aimDirection.x) ||
+      !sameBits(input.aimDirection.y, previous.aimDirection.y) ||
+      !sameBits(input.aimPower, previous.aimPower))
+    flags |= AIM;
+  if (!sameBits(input.move, previous.move))
+    flags |= MOVE;
+  if (input.jump)
+    flags |= JUMP;
+  if (input.shoot)
+    flags |= SHOOT;
+  if (input.selectWeapon)
+    flags |= WEAPON;
+
+  previous = input;
+  if (flags == 0) {
+    idleTicks++;
+    return;
+  }
+
+  flush(out);
+  out.u8(flags);
+  if (flags & AIM) {
+    out.f32(input.aimDirection.x);
+    out.f32(input.aimDirection.y);
+    out.f32(input.aimPower);
+  }
+  if (flags & MOVE)
+    out.f32(input.move);
+  if (flags & WEAPON)
+    out.u8(static_cast<std::uint8_t>(input.weapon));
+}
+
+InputDecoder::InputDecoder(const PlayerInput &previous)
+    : current(previous), idleTicks(0) {
+  // Разовые действия не переходят на следующий тик
+  current.jump = false;
+  current.shoot = false;
+  current.selectWeapon = false;
+}
+
+bool InputDecoder::next(ByteReader &in, PlayerInput &input) {
+  current.jump = false;
+  current.shoot = false;
+  current.selectWeapon = false;
+
+  if (idleTicks == 0) {
+    std::uint8_t flags = in.u8();
+    if (flags == 0) {
+      idleTicks = in.varint();
+      if (idleTicks == 0)
+        return false;
+    } else {
+      if (flags & AIM) {
+        current.aimDirection.x = in.f32();
+        current.aimDirection.y = in.f32();
+        current.aimPower = in.f32();
+      }
+      if (flags & MOVE)
+        current.move = in.f32();
+      current.jump = (flags & JUMP) != 0;
+      current.shoot = (flags & SHOOT) != 0;
+      if (flags & WEAPON) {
+        std::uint8_t weapon = in.u8();
+        if (weapon >= GameTypes::WEAPON_COUNT)
+          return false;
+        current.selectWeapon = true;
+        current.weapon = static_cast<GameTypes::WeaponType>(weapon);
+      }
+    }
+    // Прицел и движение от чужой стороны дальше идут в координаты и
+    // индексы местности: NaN или 1e30 там — неопределенное поведение
+    if (!in.ok() || !current.isValid())
+      return false;
+  }
+  if (idleTicks > 0)
+    idleTicks--;
+
+  input = current;
+  return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "../utils/BinaryIO.hpp"
+#include "PlayerInput.hpp"
+#include <cstdint>
+
+// Поток ввода по тикам в сжатом виде: записи матчей и пакеты сети.
+//
+// Тик — байт флагов и изменившиеся поля: AIM — направление и сила
+// (3 x f32), MOVE — движение (f32), WEAPON — оружие (u8); JUMP и SHOOT
+// без данных. Флаги 0 — серия тиков без изменений, за ними число тиков
+// (LEB128). Игрок между выстрелами почти не трогает ввод, поэтому
+// простой стоит пару байт на всю серию.
+class InputEncoder {
+public:
+  // previous — ввод тика перед первым записываемым
+  explicit InputEncoder(const PlayerInput &previous = PlayerInput());
+
+  void add(ByteWriter &out, const PlayerInput &input);
+  // Дописывает незакрытую серию простоя; после него можно продолжать
+  void flush(ByteWriter &out);
+
+private:
+  PlayerInput previous;
+  std::uint64_t idleTicks;
+};
+
+class InputDecoder {
+public:
+  explicit InputDecoder(const PlayerInput &previous = PlayerInput());
+
+  // false — данные кончились или испорчены; ввод вне пределов
+  // PlayerInput::isValid() тоже считается испорченным
+  bool next(ByteReader &in, PlayerInput &input);
+
+private:
+  PlayerInput current;
+  std::uint64_t idleTicks;
+};
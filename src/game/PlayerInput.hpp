@@ -0,0 +1,57 @@
+#pragma once
+#include "../utils/GameTypes.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Ввод активного игрока за один тик симуляции. Прицел и движение
+// передаются каждый тик, действия (прыжок, выстрел, смена оружия) — один
+// раз в тот тик, когда должны сработать.
+struct PlayerInput {
+  static constexpr float MAX_AIM_POWER = 100.0f;
+  // Допуск на длину направления прицела: cos/sin и нормировка во float
+  // дают единицу с ошибкой в последних битах
+  static constexpr float AIM_LENGTH_TOLERANCE = 1e-3f;
+
+  sf::Vector2f aimDirection; // единичный; нулевой — игрок еще не целился
+  float aimPower = 0.0f;     // [0, MAX_AIM_POWER]
+  float move = 0.0f;         // -1 влево, 1 вправо
+  bool jump = false;
+  bool shoot = false;
+  bool selectWeapon = false;
+  GameTypes::WeaponType weapon = GameTypes::WeaponType::BAZOOKA;
+
+  // Поля в своих пределах; NaN и бесконечности не проходят
+  bool isValid() const {
+    return validAim(aimDirection) && aimPower >= 0.0f &&
+           aimPower <= MAX_AIM_POWER && move >= -1.0f && move <= 1.0f;
+  }
+
+  // Тот же ввод с полями, приведенными в пределы. Допустимый ввод не
+  // меняется ни в одном бите, иначе разошлись бы записи матчей.
+  PlayerInput clamped() const {
+    PlayerInput result = *this;
+    if (!validAim(aimDirection)) {
+      float length = std::hypot(aimDirection.x, aimDirection.y);
+      result.aimDirection = std::isfinite(length) && length > 0.0f
+                                ? aimDirection / length
+                                : sf::Vector2f();
+    }
+    result.aimPower = clampOrZero(aimPower, 0.0f, MAX_AIM_POWER);
+    result.move = clampOrZero(move, -1.0f, 1.0f);
+    return result;
+  }
+
+private:
+  static bool validAim(sf::Vector2f direction) {
+    float squared = direction.x * direction.x + direction.y * direction.y;
+    return squared == 0.0f ||
+           std::fabs(squared - 1.0f) <= 2.0f * AIM_LENGTH_TOLERANCE;
+  }
+  // NaN — как будто поле не трогали
+  static float clampOrZero(float value, float low, float high) {
+    if (std::isnan(value))
+      return 0.0f;
+    return std::min(std::max(value, low), high);
+  }
+};
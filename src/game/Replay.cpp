@@ -0,0 +1,102 @@
+#include "Replay.hpp"
+#include "../terrain/SurfaceIndex.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+constexpr char MAGIC[4] = {'W', 'R', 'P', 'L'};
+constexpr std::uint32_t VERSION = 1;
+} // namespace
+
+ReplayRecorder::ReplayRecorder(const ReplayHeader &header)
+    : header(header), ticks(0) {}
+
+void ReplayRecorder::record(const PlayerInput &input) {
+  encoder.add(stream, input);
+  ticks++;
+}
+
+bool ReplayRecorder::save(const std::string &path, std::uint64_t finalHash) {
+  encoder.flush(stream);
+
+  ByteWriter file;
+  file.bytes(MAGIC, 4);
+  file.u32(VERSION);
+  file.u64(header.seed);
+  file.u32(header.worldWidth);
+  file.u32(header.worldHeight);
+  file.u32(header.battle.teams);
+  file.u32(header.battle.wormsPerTeam);
+  file.f32(header.tickDuration);
+  file.string(header.mapPath);
+  file.u32(ticks);
+  file.u64(finalHash);
+  file.bytes(stream.data().data(), stream.size());
+
+  FILE *out = std::fopen(path.c_str(), "wb");
+  if (!out)
+    return false;
+  bool ok = std::fwrite(file.data().data(), 1, file.size(), out) ==
+            file.size();
+  return std::fclose(out) == 0 && ok;
+}
+
+ReplayReader::ReplayReader()
+    : ticks(0), finalHash(0), reader(nullptr, 0), ticksRead(0) {}
+
+bool ReplayReader::load(const std::string &path) {
+  FILE *in = std::fopen(path.c_str(), "rb");
+  if (!in)
+    return false;
+  data.clear();
+  std::uint8_t buffer[4096];
+  std::size_t count;
+  while ((count = std::fread(buffer, 1, sizeof(buffer), in)) > 0)
+    data.insert(data.end(), buffer, buffer + count);
+  std::fclose(in);
+
+  reader = ByteReader(data.data(), data.size());
+  char magic[4];
+  reader.bytes(magic, 4);
+  std::uint32_t version = reader.u32();
+  header.seed = reader.u64();
+  std::uint32_t width = reader.u32();
+  std::uint32_t height = reader.u32();
+  std::uint32_t teams = reader.u32();
+  std::uint32_t wormsPerTeam = reader.u32();
+  header.tickDuration = reader.f32();
+  header.mapPath = reader.string();
+  std::uint32_t tickCount = reader.u32();
+  finalHash = reader.u64();
+
+  // Поля проверяются до приведения к int: из испорченного заголовка
+  // иначе строился бы мир на гигабайты или миллионы червяков
+  if (!reader.ok() || std::memcmp(magic, MAGIC, 4) != 0 ||
+      version != VERSION || width == 0 ||
+      width > static_cast<std::uint32_t>(SurfaceIndex::MAX_WIDTH) ||
+      height == 0 ||
+      height > static_cast<std::uint32_t>(SurfaceIndex::MAX_HEIGHT) ||
+      teams < 2 || teams > BattleConfig::MAX_TEAMS || wormsPerTeam < 1 ||
+      static_cast<std::uint64_t>(teams) * wormsPerTeam >
+          BattleConfig::MAX_WORMS ||
+      !(header.tickDuration > 0.0f && header.tickDuration < 1.0f) ||
+      tickCount > INT_MAX)
+    return false;
+  header.worldWidth = static_cast<int>(width);
+  header.worldHeight = static_cast<int>(height);
+  header.battle.teams = static_cast<int>(teams);
+  header.battle.wormsPerTeam = static_cast<int>(wormsPerTeam);
+  ticks = static_cast<int>(tickCount);
+
+  decoder = InputDecoder();
+  ticksRead = 0;
+  return true;
+}
+
+bool ReplayReader::next(PlayerInput &input) {
+  if (ticksRead >= ticks || !decoder.next(reader, input))
+    return false;
+  ticksRead++;
+  return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "../utils/BinaryIO.hpp"
+#include "InputCodec.hpp"
+#include "PlayerInput.hpp"
+#include "Simulation.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Все, что нужно, чтобы заново построить матч: остальное выводится из seed
+struct ReplayHeader {
+  std::uint64_t seed = 0;
+  int worldWidth = GameTypes::WORLD_WIDTH;
+  int worldHeight = GameTypes::WORLD_HEIGHT;
+  BattleConfig battle;
+  float tickDuration = 1.0f / GameTypes::SIM_TICK_RATE;
+  std::string mapPath; // пусто — карта сгенерирована из seed
+};
+
+// Запись матча (.wrpl). Числа little-endian:
+//
+//   "WRPL", версия (u32), seed (u64), ширина, высота, команды, червяки
+//   (u32), шаг (f32), путь к карте (строка), тиков (u32), хеш конца (u64)
+//
+// Дальше ввод по тикам в кодировке InputEncoder: минута матча обычно
+// занимает единицы килобайт.
+class ReplayRecorder {
+public:
+  explicit ReplayRecorder(const ReplayHeader &header);
+
+  void record(const PlayerInput &input);
+  int getTicks() const { return ticks; }
+  // finalHash — Simulation::stateHash() после последнего тика
+  bool save(const std::string &path, std::uint64_t finalHash);
+
+private:
+  ReplayHeader header;
+  ByteWriter stream;
+  InputEncoder encoder;
+  int ticks;
+};
+
+class ReplayReader {
+public:
+  ReplayReader();
+
+  // false — файла нет или это не запись матча
+  bool load(const std::string &path);
+
+  const ReplayHeader &getHeader() const { return header; }
+  int getTicks() const { return ticks; }
+  std::uint64_t getFinalHash() const { return finalHash; }
+
+  // Ввод следующего тика; false — записи кончились или испорчены. Ввод
+  // вне пределов PlayerInput::isValid() до симуляции не доходит.
+  bool next(PlayerInput &input);
+  int getTicksRead() const { return ticksRead; }
+  // Чтение остановилось на недопустимых данных, а не на конце файла
+  bool isInputCorrupt() const { return ticksRead < ticks && reader.ok(); }
+
+private:
+  ReplayHeader header;
+  int ticks;
+  std::uint64_t finalHash;
+  std::vector<std::uint8_t> data;
+  ByteReader reader;
+  InputDecoder decoder;
+  int ticksRead;
+};
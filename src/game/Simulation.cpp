@@ -0,0 +1,566 @@
+#include "Simulation.hpp"
+#include "../utils/MathUtils.hpp"
+#include "../utils/Profiler.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <utility>
+
+namespace {
+// FNV-1a по 64-битным словам: местность хешируется целыми словами чанков
+class StateHasher {
+public:
+  void word(std::uint64_t value) {
+    hash = (hash ^ value) * 0x100000001b3ULL;
+  }
+  void number(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    word(bits);
+  }
+  void vector(sf::Vector2f value) {
+    number(value.x);
+    number(value.y);
+  }
+  std::uint64_t get() const { return hash; }
+
+private:
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+constexpr std::uint8_t SNAPSHOT_VERSION = 1;
+
+void writeVector(ByteWriter &out, sf::Vector2f value) {
+  out.f32(value.x);
+  out.f32(value.y);
+}
+
+// Бесконечность или точка за пределами мира дальше превращается в
+// переполненный индекс сетки
+bool readVector(ByteReader &in, sf::Vector2f &value) {
+  value.x = in.f32();
+  value.y = in.f32();
+  return MathUtils::isWithin(value, TerrainManager::MAX_COORDINATE);
+}
+
+void writeIndices(ByteWriter &out, const std::vector<int> &values) {
+  for (int value : values)
+    out.svarint(value);
+}
+
+// Номера червяков и команд должны оставаться в пределах [0, limit).
+// Проверка идет до приведения к int, иначе большое число стало бы
+// отрицательным или попало бы в пределы по модулю.
+bool readIndices(ByteReader &in, std::vector<int> &values, int limit) {
+  for (int &value : values) {
+    std::int64_t raw = in.svarint();
+    if (raw < 0 || raw >= limit)
+      return false;
+    value = static_cast<int>(raw);
+  }
+  return true;
+}
+
+// Число без знака не больше limit
+bool readCount(ByteReader &in, int &value, int limit = INT_MAX) {
+  std::uint64_t raw = in.varint();
+  if (raw > static_cast<std::uint64_t>(limit))
+    return false;
+  value = static_cast<int>(raw);
+  return true;
+}
+} // namespace
+
+Simulation::Simulation(int worldWidth, int worldHeight, std::uint64_t seed,
+                       BattleConfig battle, ThreadPool *terrainPool)
+    : battle(battle), terrain(worldWidth, worldHeight,
+              RandomStream(seed).split(RandomStreams::TERRAIN), terrainPool),
+      currentPlayer(0), aimPower(0), gameEnded(false), winner(-1),
+      currentWeapon(GameTypes::WeaponType::BAZOOKA), turnTimer(0.0f),
+      canShoot(true), seed(seed),
+      projectileStreams(RandomStream(seed).split(RandomStreams::PROJECTILES)),
+      projectilesSpawned(0), terrainPool(terrainPool),
+      wormGrid(static_cast<float>(worldWidth), static_cast<float>(worldHeight),
+               WORM_GRID_CELL) {
+  spawnWorms();
+}
+
+Simulation::Simulation(std::shared_ptr<const MapFile> map, std::uint64_t seed,
+                       BattleConfig battle)
+    : battle(battle), terrain(std::move(map)), currentPlayer(0), aimPower(0),
+      gameEnded(false), winner(-1),
+      currentWeapon(GameTypes::WeaponType::BAZOOKA), turnTimer(0.0f),
+      canShoot(true), seed(seed),
+      projectileStreams(RandomStream(seed).split(RandomStreams::PROJECTILES)),
+      projectilesSpawned(0), terrainPool(nullptr),
+      wormGrid(static_cast<float>(terrain.getWidth()),
+               static_cast<float>(terrain.getHeight()), WORM_GRID_CELL) {
+  spawnWorms();
+}
+
+void Simulation::spawnWorms() {
+  // Червяки стоят на равных расстояниях, команды чередуются
+  int teams = std::max(1, battle.teams);
+  int total = teams * std::max(1, battle.wormsPerTeam);
+  float width = static_cast<float>(terrain.getWidth());
+  float margin = std::min(150.0f, width / 4);
+  worms.reserve(total);
+  for (int k = 0; k < total; k++) {
+    float x = total == 1 ? width / 2
+                         : margin + (width - 2 * margin) * k / (total - 1);
+    worms.push_back(Worm(x, 200, k % teams));
+  }
+
+  // Размещаем червяков на земле
+  for (auto &worm : worms) {
+    int groundLevel =
+        terrain.findGroundLevel(static_cast<int>(worm.position.x));
+    worm.position.y = groundLevel - 20;
+    worm.previousPosition = worm.position;
+  }
+
+  buildTurnQueue();
+
+  // Первым ходит первый червяк первой команды
+  currentPlayer = 0;
+  worms[currentPlayer].isMyTurn = true;
+  teamCursor[0] = wormNext[0];
+  nextTeam = teamNext[0];
+}
+
+void Simulation::buildTurnQueue() {
+  int teams = std::max(1, battle.teams);
+  int total = static_cast<int>(worms.size());
+  int perTeam = total / teams;
+
+  // Червяк k принадлежит команде k % teams, соседи по команде — k ± teams
+  wormNext.resize(total);
+  wormPrev.resize(total);
+  for (int k = 0; k < total; k++) {
+    wormNext[k] = (k + teams) % total;
+    wormPrev[k] = (k - teams + total) % total;
+  }
+
+  teamNext.resize(teams);
+  teamPrev.resize(teams);
+  teamCursor.resize(teams);
+  teamAliveWorms.assign(teams, perTeam);
+  for (int t = 0; t < teams; t++) {
+    teamNext[t] = (t + 1) % teams;
+    teamPrev[t] = (t - 1 + teams) % teams;
+    teamCursor[t] = t;
+  }
+  aliveWorms = total;
+  aliveTeams = teams;
+}
+
+void Simulation::onWormDied(int index) {
+  int team = worms[index].teamId;
+  aliveWorms--;
+  if (--teamAliveWorms[team] == 0) {
+    aliveTeams--;
+    if (nextTeam == team)
+      nextTeam = teamNext[team];
+    teamNext[teamPrev[team]] = teamNext[team];
+    teamPrev[teamNext[team]] = teamPrev[team];
+    return;
+  }
+
+  if (teamCursor[team] == index)
+    teamCursor[team] = wormNext[index];
+  wormNext[wormPrev[index]] = wormNext[index];
+  wormPrev[wormNext[index]] = wormPrev[index];
+}
+
+void Simulation::restart(std::uint64_t newSeed) {
+  seed = newSeed;
+  RandomStream matchRng(seed);
+  projectileStreams = matchRng.split(RandomStreams::PROJECTILES);
+  projectilesSpawned = 0;
+
+  worms.clear();
+  projectiles.clear();
+  if (terrain.getSource()) {
+    terrain.loadMap();
+  } else {
+    terrain.generateTerrain(matchRng.split(RandomStreams::TERRAIN),
+                            terrainPool);
+  }
+
+  spawnWorms();
+
+  gameEnded = false;
+  winner = -1;
+  currentWeapon = GameTypes::WeaponType::BAZOOKA;
+  canShoot = true;
+  turnTimer = 0.0f;
+  stats = MatchStats();
+}
+
+void Simulation::applyInput(const PlayerInput &rawInput) {
+  // Ввод мог прийти не через декодер: поля приводим в пределы, как и
+  // поля снимка
+  PlayerInput input = rawInput.clamped();
+  aimDirection = input.aimDirection;
+  aimPower = input.aimPower;
+
+  Worm &activeWorm = worms[currentPlayer];
+  if (!activeWorm.isActive || !activeWorm.isMyTurn)
+    return;
+
+  if (input.selectWeapon) {
+    currentWeapon = input.weapon;
+  }
+
+  if (input.jump) {
+    sf::Vector2f jumpDir = aimDirection;
+    jumpDir.y = std::min(jumpDir.y, -0.3f);
+    activeWorm.jump(jumpDir);
+  }
+
+  if (input.shoot && canShoot) {
+    shoot();
+    return;
+  }
+
+  if (input.move != 0.0f) {
+    activeWorm.move(input.move);
+  }
+}
+
+void Simulation::shoot() {
+  Worm &activeWorm = worms[currentPlayer];
+
+  float power = GameTypes::launchSpeed(currentWeapon, aimPower);
+  sf::Vector2f spawnPos =
+      activeWorm.getCenter() + aimDirection * GameTypes::MUZZLE_OFFSET;
+
+  projectiles.spawn(spawnPos, aimDirection * power, activeWorm.teamId,
+                    currentWeapon,
+                    projectileStreams.split(projectilesSpawned++));
+
+  stats.turns++;
+  stats.shotsByWeapon[static_cast<int>(currentWeapon)]++;
+
+  canShoot = false;
+  activeWorm.isMyTurn = false;
+  switchToNextPlayer();
+}
+
+int Simulation::explosionDamage(int damage, float radius, float distance,
+                                bool sameTeam) {
+  if (distance >= radius)
+    return 0;
+  int result = static_cast<int>(damage * (1.0f - distance / radius));
+  // Своим достается треть урона
+  return sameTeam ? result / 3 : result;
+}
+
+void Simulation::switchToNextPlayer() {
+  if (aliveTeams == 0)
+    return;
+
+  int team = nextTeam;
+  currentPlayer = teamCursor[team];
+  teamCursor[team] = wormNext[currentPlayer];
+  nextTeam = teamNext[team];
+
+  worms[currentPlayer].isMyTurn = true;
+  canShoot = true;
+  turnTimer = 0.0f;
+}
+
+void Simulation::step(const PlayerInput &input, float deltaTime) {
+  PROFILE_ZONE("sim.step");
+  if (gameEnded)
+    return;
+
+  turnTimer += deltaTime;
+  stats.simTime += deltaTime;
+
+  applyInput(input);
+
+  {
+    PROFILE_ZONE("sim.worms");
+    for (size_t i = 0; i < worms.size(); i++) {
+      bool wasActive = worms[i].isActive;
+      worms[i].update(deltaTime, terrain);
+      if (wasActive && !worms[i].isActive)
+        onWormDied(static_cast<int>(i));
+    }
+  }
+
+  // Дальше в тике червяки не сдвигаются (взрыв меняет только скорость),
+  // так что одной перестройки сетки хватает на все снаряды
+  wormGrid.rebuild(worms.size(),
+                   [this](std::size_t i) { return worms[i].getCenter(); });
+
+  // Осколки, рожденные на этом тике, начнут двигаться со следующего
+  PROFILE_ZONE("sim.projectiles");
+  size_t liveCount = projectiles.size();
+  for (size_t i = 0; i < liveCount; i++) {
+    std::uint32_t slot = projectiles.getLiveSlots()[i];
+    projectiles.update(slot, deltaTime, terrain);
+
+    // Из задетых червяков срабатывает первый по порядку
+    std::uint32_t hitWorm = NO_WORM;
+    wormGrid.forEachNear(
+        projectiles.positions[slot], ProjectilePool::WORM_HIT_DISTANCE,
+        [&](std::uint32_t index) {
+          if (index < hitWorm &&
+              projectiles.checkWormCollision(slot, worms[index]))
+            hitWorm = index;
+        });
+    if (hitWorm == NO_WORM)
+      continue;
+
+    sf::Vector2f explosionPos = projectiles.positions[slot];
+    float explosionRadius = projectiles.explosionRadii[slot];
+    int weapon = static_cast<int>(projectiles.getSourceWeapon(slot));
+    wormGrid.forEachNear(
+        explosionPos, explosionRadius, [&](std::uint32_t index) {
+          Worm &targetWorm = worms[index];
+          float distanceLength =
+              MathUtils::distance(explosionPos, targetWorm.getCenter());
+          if (distanceLength >= explosionRadius)
+            return;
+
+          int damage = explosionDamage(
+              projectiles.damages[slot], explosionRadius, distanceLength,
+              targetWorm.teamId == projectiles.shooterTeams[slot]);
+
+          int healthBefore = targetWorm.health;
+          bool wasActive = targetWorm.isActive;
+          targetWorm.takeDamage(damage);
+          stats.damageByWeapon[weapon] += healthBefore - targetWorm.health;
+          if (wasActive && !targetWorm.isActive)
+            onWormDied(static_cast<int>(index));
+
+          if (distanceLength > 0) {
+            sf::Vector2f knockback = (targetWorm.getCenter() - explosionPos);
+            knockback = MathUtils::normalize(knockback);
+            targetWorm.velocity += knockback * 150.0f;
+          }
+        });
+
+    projectiles.explode(slot, terrain);
+  }
+
+  projectiles.releaseInactive();
+
+  if (aliveTeams <= 1) {
+    gameEnded = true;
+    // Курсор следующей команды всегда стоит на живой команде
+    winner = aliveTeams == 1 ? nextTeam : -1;
+    return;
+  }
+
+  // Червяк погиб в свой ход, не успев выстрелить: ход переходит дальше
+  Worm &activeWorm = worms[currentPlayer];
+  if (!activeWorm.isActive && activeWorm.isMyTurn) {
+    activeWorm.isMyTurn = false;
+    switchToNextPlayer();
+  }
+}
+
+std::uint64_t Simulation::stateHash() const { return hashState(true); }
+
+std::uint64_t Simulation::checksum() const { return hashState(false); }
+
+std::uint64_t Simulation::hashState(bool terrainWords) const {
+  StateHasher hasher;
+  for (const Worm &worm : worms) {
+    hasher.vector(worm.position);
+    hasher.vector(worm.velocity);
+    hasher.word(static_cast<std::uint32_t>(worm.health));
+    hasher.word(worm.isActive | worm.isGrounded << 1 | worm.canJump << 2 |
+                worm.isMyTurn << 3);
+    hasher.number(worm.jumpCooldown);
+  }
+
+  // Номера слотов зависят от истории пула, а не матча: в хеш идет только
+  // содержимое в порядке обновления
+  for (std::uint32_t slot : projectiles.getLiveSlots()) {
+    hasher.vector(projectiles.positions[slot]);
+    hasher.vector(projectiles.velocities[slot]);
+    hasher.word(projectiles.activeFlags[slot]);
+    hasher.word(static_cast<std::uint32_t>(projectiles.weaponTypes[slot]));
+    hasher.number(projectiles.penetrationPowers[slot]);
+    hasher.word(projectiles.rngs[slot].getCounter());
+  }
+
+  hasher.word(static_cast<std::uint32_t>(currentPlayer));
+  hasher.word(static_cast<std::uint32_t>(nextTeam));
+  hasher.word(static_cast<std::uint32_t>(currentWeapon));
+  hasher.word(gameEnded | canShoot << 1);
+  hasher.word(static_cast<std::uint32_t>(winner));
+  hasher.number(turnTimer);
+  hasher.word(projectilesSpawned);
+
+  if (!terrainWords) {
+    hasher.word(terrain.getDestructionsHash());
+    return hasher.get();
+  }
+
+  // Пустые чанки пропускаются, но номер непустого входит в хеш
+  const OccupancyGrid &grid = terrain.getGrid();
+  for (int cy = 0; cy < grid.getChunksY(); cy++) {
+    for (int cx = 0; cx < grid.getChunksX(); cx++) {
+      const OccupancyGrid::Chunk *chunk = grid.chunkAt(cx, cy);
+      if (!chunk)
+        continue;
+      hasher.word(static_cast<std::uint64_t>(cy) << 32 |
+                  static_cast<std::uint32_t>(cx));
+      for (OccupancyGrid::Word word : chunk->words)
+        hasher.word(word);
+    }
+  }
+  return hasher.get();
+}
+
+void Simulation::writeSnapshot(ByteWriter &out) const {
+  out.u8(SNAPSHOT_VERSION);
+  out.u64(seed);
+  out.varint(terrain.getWidth());
+  out.varint(terrain.getHeight());
+  out.u8(terrain.getSource() ? 1 : 0);
+  out.varint(battle.teams);
+  out.varint(battle.wormsPerTeam);
+  terrain.writeDestructions(out);
+
+  for (const Worm &worm : worms) {
+    writeVector(out, worm.position);
+    writeVector(out, worm.previousPosition);
+    writeVector(out, worm.velocity);
+    out.svarint(worm.health);
+    out.u8(worm.isActive | worm.isGrounded << 1 | worm.canJump << 2 |
+           worm.isMyTurn << 3);
+    out.f32(worm.jumpCooldown);
+  }
+  projectiles.write(out);
+
+  out.varint(currentPlayer);
+  writeVector(out, aimDirection);
+  out.f32(aimPower);
+  out.u8(gameEnded | canShoot << 1);
+  out.svarint(winner);
+  out.u8(static_cast<std::uint8_t>(currentWeapon));
+  out.f32(turnTimer);
+  out.varint(projectilesSpawned);
+
+  out.varint(stats.turns);
+  out.f32(stats.simTime);
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++) {
+    out.varint(stats.shotsByWeapon[w]);
+    out.varint(stats.damageByWeapon[w]);
+  }
+
+  writeIndices(out, wormNext);
+  writeIndices(out, wormPrev);
+  writeIndices(out, teamNext);
+  writeIndices(out, teamPrev);
+  writeIndices(out, teamCursor);
+  writeIndices(out, teamAliveWorms);
+  out.varint(nextTeam);
+  out.varint(aliveWorms);
+  out.varint(aliveTeams);
+}
+
+bool Simulation::readSnapshot(ByteReader &in) {
+  // Читаем в копию: при ошибке посередине текущее состояние не страдает
+  Simulation next(*this);
+  if (!next.readState(in))
+    return false;
+  *this = std::move(next);
+  return true;
+}
+
+bool Simulation::readState(ByteReader &in) {
+  if (in.u8() != SNAPSHOT_VERSION)
+    return false;
+  std::uint64_t snapshotSeed = in.u64();
+  bool sameSetup =
+      in.varint() == static_cast<std::uint64_t>(terrain.getWidth()) &&
+      in.varint() == static_cast<std::uint64_t>(terrain.getHeight()) &&
+      in.u8() == (terrain.getSource() ? 1 : 0) &&
+      in.varint() == static_cast<std::uint64_t>(battle.teams) &&
+      in.varint() == static_cast<std::uint64_t>(battle.wormsPerTeam);
+  std::vector<TerrainDestruction> journal;
+  if (!sameSetup || !TerrainManager::readDestructions(in, journal))
+    return false;
+
+  int total = static_cast<int>(worms.size());
+  int teams = static_cast<int>(teamNext.size());
+  for (Worm &worm : worms) {
+    if (!readVector(in, worm.position) ||
+        !readVector(in, worm.previousPosition) ||
+        !readVector(in, worm.velocity))
+      return false;
+    // Урон только уменьшает здоровье до нуля, отрицательного не бывает
+    std::int64_t health = in.svarint();
+    if (health < 0 || health > INT_MAX)
+      return false;
+    worm.health = static_cast<int>(health);
+    std::uint8_t flags = in.u8();
+    worm.isActive = flags & 1;
+    worm.isGrounded = (flags >> 1) & 1;
+    worm.canJump = (flags >> 2) & 1;
+    worm.isMyTurn = (flags >> 3) & 1;
+    worm.jumpCooldown = in.f32();
+  }
+  if (!projectiles.read(in))
+    return false;
+
+  if (!readCount(in, currentPlayer, total - 1))
+    return false;
+  if (!readVector(in, aimDirection))
+    return false;
+  aimPower = in.f32();
+  std::uint8_t flags = in.u8();
+  gameEnded = flags & 1;
+  canShoot = (flags >> 1) & 1;
+  std::int64_t winnerIndex = in.svarint();
+  std::uint8_t weapon = in.u8();
+  turnTimer = in.f32();
+  projectilesSpawned = in.varint();
+  if (winnerIndex < -1 || winnerIndex >= teams ||
+      weapon >= GameTypes::WEAPON_COUNT)
+    return false;
+  winner = static_cast<int>(winnerIndex);
+  currentWeapon = static_cast<GameTypes::WeaponType>(weapon);
+
+  if (!readCount(in, stats.turns))
+    return false;
+  stats.simTime = in.f32();
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++) {
+    if (!readCount(in, stats.shotsByWeapon[w]) ||
+        !readCount(in, stats.damageByWeapon[w]))
+      return false;
+  }
+
+  if (!readIndices(in, wormNext, total) || !readIndices(in, wormPrev, total) ||
+      !readIndices(in, teamNext, teams) || !readIndices(in, teamPrev, teams) ||
+      !readIndices(in, teamCursor, total) ||
+      !readIndices(in, teamAliveWorms, total + 1))
+    return false;
+  if (!readCount(in, nextTeam, teams - 1) ||
+      !readCount(in, aliveWorms, total) || !readCount(in, aliveTeams, teams) ||
+      !in.ok())
+    return false;
+
+  // Местность: если журнал снимка продолжает текущий, дорисовываем
+  // остаток, иначе возвращаем карту в исходный вид и проходим его целиком
+  if (snapshotSeed != seed || !terrain.catchUp(journal)) {
+    seed = snapshotSeed;
+    RandomStream matchRng(seed);
+    projectileStreams = matchRng.split(RandomStreams::PROJECTILES);
+    if (terrain.getSource()) {
+      terrain.loadMap();
+    } else {
+      terrain.generateTerrain(matchRng.split(RandomStreams::TERRAIN),
+                              terrainPool);
+    }
+    terrain.catchUp(journal);
+  }
+  return true;
+}
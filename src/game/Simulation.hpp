@@ -0,0 +1,149 @@
+#pragma once
+#include "../entities/ProjectilePool.hpp"
+#include "../entities/Worm.hpp"
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/BinaryIO.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/SpatialGrid.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "PlayerInput.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Счетчики матча для статистики и балансировки оружия
+struct MatchStats {
+  int turns = 0;
+  float simTime = 0.0f;
+  int shotsByWeapon[GameTypes::WEAPON_COUNT] = {};
+  int damageByWeapon[GameTypes::WEAPON_COUNT] = {};
+};
+
+// Состав матча: N команд по M червяков. Команды ходят по кругу, внутри
+// команды червяки тоже ходят по очереди.
+struct BattleConfig {
+  // Пределы для состава матча из файлов и сети: на порядки больше любого
+  // реального боя, но не дают выделить память под миллионы червяков
+  static constexpr int MAX_TEAMS = 1024;
+  static constexpr int MAX_WORMS = 1 << 16; // всего в матче
+
+  int teams = 2;
+  int wormsPerTeam = 1;
+
+  // Хотя бы две команды по червяку и не больше пределов выше; умножение
+  // не переполняется
+  bool isValid() const {
+    return teams >= 2 && teams <= MAX_TEAMS && wormsPerTeam >= 1 &&
+           wormsPerTeam <= MAX_WORMS / teams;
+  }
+};
+
+// Состояние и правила матча без окна и графики: местность, червяки,
+// снаряды и очередность ходов. Продвигается только через step().
+class Simulation {
+private:
+  BattleConfig battle;
+  TerrainManager terrain;
+  std::vector<Worm> worms;
+  ProjectilePool projectiles;
+  int currentPlayer;
+  sf::Vector2f aimDirection;
+  float aimPower;
+  bool gameEnded;
+  int winner;
+  GameTypes::WeaponType currentWeapon;
+  float turnTimer;
+  bool canShoot;
+  MatchStats stats;
+
+  // Весь матч выводится из одного seed
+  std::uint64_t seed;
+  RandomStream projectileStreams;
+  std::uint64_t projectilesSpawned;
+  ThreadPool *terrainPool; // для новых карт в restart()
+
+  // Сетка по центрам червяков для попаданий и радиуса взрыва
+  static constexpr float WORM_GRID_CELL = 64.0f;
+  static constexpr std::uint32_t NO_WORM = 0xffffffffu;
+  SpatialGrid wormGrid;
+
+  // Очередь ходов: живые команды и живые червяки каждой команды связаны в
+  // кольцевые списки. Погибший вынимается за O(1), выбор следующего хода
+  // тоже O(1). Вынутый узел сохраняет ссылку вперед, поэтому курсоры,
+  // указывавшие на него, сдвигаются на его соседа.
+  std::vector<int> wormNext, wormPrev;
+  std::vector<int> teamNext, teamPrev;
+  std::vector<int> teamCursor; // следующий ходящий червяк команды
+  std::vector<int> teamAliveWorms;
+  int nextTeam;
+  int aliveWorms;
+  int aliveTeams;
+
+  void spawnWorms();
+  void buildTurnQueue();
+  void onWormDied(int index);
+  void applyInput(const PlayerInput &input);
+  void shoot();
+  void switchToNextPlayer();
+  bool readState(ByteReader &in);
+  std::uint64_t hashState(bool terrainWords) const;
+
+public:
+  // terrainPool ускоряет генерацию больших карт и на исход не влияет
+  Simulation(int worldWidth, int worldHeight, std::uint64_t seed,
+             BattleConfig battle = BattleConfig(),
+             ThreadPool *terrainPool = nullptr);
+  // Матч на готовой карте; restart() возвращает ее в исходный вид
+  Simulation(std::shared_ptr<const MapFile> map, std::uint64_t seed,
+             BattleConfig battle = BattleConfig());
+
+  // Урон от взрыва на расстоянии distance от центра: линейно спадает к краю
+  static int explosionDamage(int damage, float radius, float distance,
+                             bool sameTeam);
+
+  // Снимок в памяти — просто копия симуляции: местность копии делит чанки
+  // и блоки индекса поверхности с оригиналом, поэтому копия стоит
+  // килобайты, а не всю сетку. Присваивание снимка (откат) сохраняет
+  // наблюдателям местности возможность дорисовать разницу.
+  Simulation(const Simulation &) = default;
+  Simulation(Simulation &&) = default;
+  Simulation &operator=(const Simulation &) = default;
+  Simulation &operator=(Simulation &&) = default;
+
+  // Двоичный снимок: червяки, снаряды, очередность ходов и местность в
+  // виде журнала разрушений поверх карты. Читается в симуляцию с тем же
+  // размером мира, составом и источником карты; seed берется из снимка.
+  // При ошибке чтения симуляция не меняется.
+  void writeSnapshot(ByteWriter &out) const;
+  bool readSnapshot(ByteReader &in);
+
+  void restart(std::uint64_t newSeed);
+  void step(const PlayerInput &input, float deltaTime);
+
+  const TerrainManager &getTerrain() const { return terrain; }
+  const std::vector<Worm> &getWorms() const { return worms; }
+  const ProjectilePool &getProjectiles() const { return projectiles; }
+  const Worm &getActiveWorm() const { return worms[currentPlayer]; }
+  int getCurrentPlayer() const { return currentPlayer; }
+  GameTypes::WeaponType getCurrentWeapon() const { return currentWeapon; }
+  bool isGameOver() const { return gameEnded; }
+  // Команда-победитель, -1 — ничья
+  int getWinner() const { return winner; }
+  const BattleConfig &getBattle() const { return battle; }
+  int getAliveWorms() const { return aliveWorms; }
+  int getAliveTeams() const { return aliveTeams; }
+  int getTeamAliveWorms(int team) const { return teamAliveWorms[team]; }
+  float getTurnTime() const { return turnTimer; }
+  bool canActiveWormShoot() const { return canShoot; }
+  const MatchStats &getStats() const { return stats; }
+  std::uint64_t getSeed() const { return seed; }
+
+  // Отпечаток состояния матча: червяки, снаряды, очередь ходов и
+  // местность. Совпадает у двух прогонов с одинаковым seed и вводом, если
+  // симуляция детерминирована.
+  std::uint64_t stateHash() const;
+  // То же для сверки каждый тик: местность представлена хешем журнала
+  // разрушений, так что цена не зависит от размера карты
+  std::uint64_t checksum() const;
+};
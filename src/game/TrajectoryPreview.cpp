@@ -0,0 +1,184 @@
+#include "TrajectoryPreview.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Первая точка входа в твердые клетки столбца при монотонном движении по
+// вертикали от yFrom к yTo. Выше и ниже карты — как сплошная местность,
+// так же считает TerrainManager::isColliding.
+bool hitInColumn(const std::vector<SurfaceIndex::Span> &spans, float height,
+                 float yFrom, float yTo, float &hitY) {
+  if (yTo >= yFrom) {
+    for (const auto &span : spans) {
+      if (span.bottom + 1 <= yFrom)
+        continue;
+      if (span.top > yTo)
+        return false;
+      hitY = std::max<float>(span.top, yFrom);
+      return true;
+    }
+    if (yTo < height)
+      return false;
+    hitY = std::max(height, yFrom);
+    return true;
+  }
+  for (auto it = spans.rbegin(); it != spans.rend(); ++it) {
+    if (it->top > yFrom)
+      continue;
+    if (it->bottom + 1 < yTo)
+      return false;
+    hitY = std::min<float>(it->bottom + 1, yFrom);
+    return true;
+  }
+  if (yTo >= 0.0f)
+    return false;
+  hitY = std::min(0.0f, yFrom);
+  return true;
+}
+} // namespace
+
+bool TrajectoryPreview::update(const Simulation &simulation,
+                               const PlayerInput &input) {
+  const Worm &activeWorm = simulation.getActiveWorm();
+  if (simulation.isGameOver() || !activeWorm.isMyTurn) {
+    clear();
+    return false;
+  }
+
+  Key key{activeWorm.getCenter(), input.aimDirection, input.aimPower,
+          simulation.getCurrentWeapon()};
+  const TerrainManager &terrain = simulation.getTerrain();
+  if (valid && matches(key) && !terrainChangedNearPath(terrain))
+    return false;
+
+  compute(terrain, key);
+  return true;
+}
+
+void TrajectoryPreview::clear() {
+  valid = false;
+  points.clear();
+}
+
+bool TrajectoryPreview::matches(const Key &key) const {
+  return key.origin == cachedKey.origin &&
+         key.aimDirection == cachedKey.aimDirection &&
+         key.aimPower == cachedKey.aimPower && key.weapon == cachedKey.weapon;
+}
+
+bool TrajectoryPreview::terrainChangedNearPath(const TerrainManager &terrain) {
+  if (terrain.getMapVersion() != mapVersion)
+    return true;
+
+  // Местность между перегенерациями только убывает, поэтому путь может
+  // измениться лишь от воронки, задевшей его прямоугольник (в том числе
+  // клетку, в которую он упирался)
+  const auto &destructions = terrain.getDestructions();
+  bool changed = false;
+  for (; seenDestructions < destructions.size(); seenDestructions++) {
+    const TerrainDestruction &d = destructions[seenDestructions];
+    if (d.centerX + d.radius >= minX - 1 && d.centerX - d.radius <= maxX + 1 &&
+        d.centerY + d.radius >= minY - 1 && d.centerY - d.radius <= maxY + 1)
+      changed = true;
+  }
+  return changed;
+}
+
+void TrajectoryPreview::compute(const TerrainManager &terrain,
+                                const Key &key) {
+  valid = true;
+  cachedKey = key;
+  mapVersion = terrain.getMapVersion();
+  seenDestructions = terrain.getDestructions().size();
+  points.clear();
+
+  const SurfaceIndex &surface = terrain.getSurface();
+  const int width = terrain.getWidth();
+  const float height = static_cast<float>(terrain.getHeight());
+
+  const sf::Vector2f start =
+      key.origin + key.aimDirection * GameTypes::MUZZLE_OFFSET;
+  const sf::Vector2f velocity =
+      key.aimDirection * GameTypes::launchSpeed(key.weapon, key.aimPower);
+  const float gravity = GameTypes::projectileGravity(key.weapon);
+  // ProjectilePool::update сначала меняет скорость, потом позицию, поэтому
+  // к тику n снаряд ниже точной параболы на g*dt*t/2: в сумме
+  // y0 + v*t + g*t*(t + dt)/2 при t = n*dt. Эта формула совпадает с
+  // симуляцией в каждом тике и между тиками остается параболой.
+  const float dt = 1.0f / GameTypes::SIM_TICK_RATE;
+  auto yAt = [&](float t) {
+    return start.y + velocity.y * t + 0.5f * gravity * t * (t + dt);
+  };
+  // Вершина: производная v + g*(2t + dt)/2 обращается в ноль
+  const float apex = -(velocity.y + 0.5f * gravity * dt) / gravity;
+
+  // Идем по столбцам, которые пересекает парабола: x(t) линейна, поэтому
+  // время входа и выхода из столбца известно точно. Внутри столбца y
+  // монотонна, кроме отрезка с вершиной — его делим на два.
+  float endTime = MAX_TIME;
+  float hitY = 0.0f;
+  const int step = velocity.x >= 0 ? 1 : -1;
+  int column = static_cast<int>(std::floor(start.x));
+  float tEnter = 0.0f;
+  while (tEnter < endTime) {
+    if (column < 0 || column >= width) {
+      endTime = tEnter;
+      break;
+    }
+
+    float tExit = MAX_TIME;
+    if (std::abs(velocity.x) > 1e-6f) {
+      float boundary = static_cast<float>(step > 0 ? column + 1 : column);
+      tExit = std::min((boundary - start.x) / velocity.x, MAX_TIME);
+    }
+
+    const auto &spans = surface.spansAt(column);
+    float pieces[3] = {tEnter, tExit, tExit};
+    int pieceCount = 1;
+    if (apex > tEnter && apex < tExit) {
+      pieces[1] = apex;
+      pieceCount = 2;
+    }
+
+    bool hit = false;
+    for (int i = 0; i < pieceCount && !hit; i++) {
+      float t0 = pieces[i], t1 = pieces[i + 1];
+      float y0 = yAt(t0), y1 = yAt(t1);
+      if (!hitInColumn(spans, height, y0, y1, hitY))
+        continue;
+      // Время, когда y(t) = hitY на монотонном отрезке [t0, t1]
+      float lo = t0, hi = t1;
+      bool descending = y1 >= y0;
+      for (int k = 0; k < 20; k++) {
+        float mid = 0.5f * (lo + hi);
+        if ((yAt(mid) < hitY) == descending)
+          lo = mid;
+        else
+          hi = mid;
+      }
+      endTime = y0 == hitY ? t0 : hi;
+      hit = true;
+    }
+    if (hit)
+      break;
+
+    tEnter = tExit;
+    column += step;
+  }
+
+  for (float t = 0.0f; t < endTime; t += POINT_INTERVAL)
+    points.push_back(sf::Vector2f(start.x + velocity.x * t, yAt(t)));
+  points.push_back(sf::Vector2f(start.x + velocity.x * endTime, yAt(endTime)));
+
+  minX = maxX = start.x;
+  minY = maxY = start.y;
+  for (const auto &point : points) {
+    minX = std::min(minX, point.x);
+    maxX = std::max(maxX, point.x);
+    minY = std::min(minY, point.y);
+    maxY = std::max(maxY, point.y);
+  }
+  // Вершина параболы может лежать между точками
+  if (apex > 0 && apex < endTime)
+    minY = std::min(minY, yAt(apex));
+}
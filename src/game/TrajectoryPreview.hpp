@@ -0,0 +1,46 @@
+#pragma once
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/GameTypes.hpp"
+#include "PlayerInput.hpp"
+#include "Simulation.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// Предпросмотр траектории выстрела активного червяка. Путь считается в
+// замкнутом виде по той же схеме шагов, что и полет снаряда, против
+// индекса поверхности и кешируется: пересчет нужен, только если
+// сменились позиция, прицел, мощность или оружие либо воронка задела
+// область, через которую проходит путь.
+class TrajectoryPreview {
+public:
+  static constexpr float POINT_INTERVAL = 0.05f; // секунды между точками
+  static constexpr float MAX_TIME = 5.0f;
+
+  // Возвращает true, если путь был пересчитан
+  bool update(const Simulation &simulation, const PlayerInput &input);
+  void clear();
+
+  const std::vector<sf::Vector2f> &getPoints() const { return points; }
+
+private:
+  struct Key {
+    sf::Vector2f origin;
+    sf::Vector2f aimDirection;
+    float aimPower;
+    GameTypes::WeaponType weapon;
+  };
+
+  bool matches(const Key &key) const;
+  bool terrainChangedNearPath(const TerrainManager &terrain);
+  void compute(const TerrainManager &terrain, const Key &key);
+
+  bool valid = false;
+  Key cachedKey{};
+  std::uint64_t mapVersion = 0;
+  std::size_t seenDestructions = 0;
+
+  std::vector<sf::Vector2f> points;
+  // Ограничивающий прямоугольник пути вместе с точкой попадания
+  float minX = 0, minY = 0, maxX = 0, maxY = 0;
+};
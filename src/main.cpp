@@ -1,7 +1,159 @@
 #include "game/Game.hpp"
+#include "terrain/SurfaceIndex.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
 
-int main() {
-  Game game;
+// sfml-app [--teams N] [--worms M] [--world WxH | --map file]
+//           [--record file] — большой бой из N команд по M червяков, при
+// желании на карте больше окна или на карте из файла (см. sim-batch
+// --save-map), с записью ввода каждого матча
+// sfml-app --replay file [--speed N] — просмотр записи в N раз быстрее
+// sfml-app --listen PORT | --connect HOST:PORT [--seed S] [--delay N]
+//          [--latency MS] [--loss P] — игра вдвоем по сети: первый ждет на
+// порту и играет четными командами, второй подключается. Seed, мир и
+// состав матча задаются у обоих одинаково; --delay — задержка ввода в
+// тиках, --latency и --loss добавляют свою задержку и потери пакетов
+// sfml-app ... --spectators PORT — в любом режиме еще и транслировать матч
+// зрителям по TCP
+// sfml-app ... --profile file — при выходе записать профиль кадров (.json —
+// Chrome trace, иначе CSV); только в сборке make PROFILE=1, панель — F3
+int main(int argc, char **argv) {
+  BattleConfig battle;
+  sf::Vector2i worldSize(GameTypes::WORLD_WIDTH, GameTypes::WORLD_HEIGHT);
+  std::shared_ptr<MapFile> map;
+  std::string recordPath;
+  std::unique_ptr<ReplayReader> replay;
+  float speed = 1.0f;
+  LockstepConfig lockstep;
+  bool online = false;
+  std::uint64_t seed = 1;
+  int spectatorPort = -1;
+  std::string profilePath;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--teams") {
+      battle.teams = std::max(2, std::atoi(argv[i + 1]));
+    } else if (arg == "--worms") {
+      battle.wormsPerTeam = std::max(1, std::atoi(argv[i + 1]));
+    } else if (arg == "--world") {
+      int width, height;
+      if (std::sscanf(argv[i + 1], "%dx%d", &width, &height) == 2) {
+        worldSize.x = std::max(GameTypes::WINDOW_WIDTH / 2,
+                               std::min(width, SurfaceIndex::MAX_WIDTH));
+        worldSize.y = std::max(GameTypes::WINDOW_HEIGHT / 2,
+                               std::min(height, SurfaceIndex::MAX_HEIGHT));
+      }
+    } else if (arg == "--map") {
+      map = std::make_shared<MapFile>();
+      if (!map->open(argv[i + 1])) {
+        std::fprintf(stderr, "%s: not a valid map file\n", argv[i + 1]);
+        return 1;
+      }
+    } else if (arg == "--record") {
+      recordPath = argv[i + 1];
+    } else if (arg == "--replay") {
+      replay.reset(new ReplayReader());
+      if (!replay->load(argv[i + 1])) {
+        std::fprintf(stderr, "%s: not a valid replay file\n", argv[i + 1]);
+        return 1;
+      }
+    } else if (arg == "--speed") {
+      speed = std::max(0.1f, static_cast<float>(std::atof(argv[i + 1])));
+    } else if (arg == "--listen") {
+      online = true;
+      lockstep.localPeer = 0;
+      lockstep.port = static_cast<std::uint16_t>(std::atoi(argv[i + 1]));
+    } else if (arg == "--connect") {
+      online = true;
+      lockstep.localPeer = 1;
+      lockstep.peers.assign(2, NetAddress());
+      if (!NetAddress::parse(argv[i + 1], lockstep.peers[0])) {
+        std::fprintf(stderr, "%s: expected host:port\n", argv[i + 1]);
+        return 1;
+      }
+    } else if (arg == "--seed") {
+      seed = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (arg == "--delay") {
+      lockstep.inputDelay = std::max(1, std::atoi(argv[i + 1]));
+    } else if (arg == "--latency") {
+      lockstep.link.latency =
+          std::max(0.0f, static_cast<float>(std::atof(argv[i + 1]))) / 1000;
+    } else if (arg == "--loss") {
+      lockstep.link.loss = std::max(
+          0.0f, std::min(0.9f, static_cast<float>(std::atof(argv[i + 1]))));
+    } else if (arg == "--spectators") {
+      spectatorPort = std::max(0, std::atoi(argv[i + 1]));
+    } else if (arg == "--profile") {
+      if (Profiler::ENABLED)
+        profilePath = argv[i + 1];
+      else
+        std::fprintf(stderr, "--profile: built without the profiler, "
+                             "rebuild with make PROFILE=1\n");
+    }
+  }
+
+  // Иначе запись такого матча потом не откроется
+  if (!battle.isValid()) {
+    std::fprintf(stderr,
+                 "--teams/--worms: at most %d teams and %d worms in "
+                 "total\n",
+                 BattleConfig::MAX_TEAMS, BattleConfig::MAX_WORMS);
+    return 1;
+  }
+
+  // Запись сама задает мир, карту и состав матча
+  if (replay) {
+    const ReplayHeader &header = replay->getHeader();
+    battle = header.battle;
+    worldSize = sf::Vector2i(header.worldWidth, header.worldHeight);
+    map.reset();
+    if (!header.mapPath.empty()) {
+      map = std::make_shared<MapFile>();
+      if (!map->open(header.mapPath)) {
+        std::fprintf(stderr, "%s: not a valid map file\n",
+                     header.mapPath.c_str());
+        return 1;
+      }
+    }
+  }
+
+  std::unique_ptr<LockstepSession> session;
+  if (online && !replay) {
+    lockstep.peers.resize(2);
+    lockstep.linkSeed = seed;
+    session.reset(new LockstepSession(lockstep));
+    if (!session->open()) {
+      std::perror("cannot open a UDP socket");
+      return 1;
+    }
+    std::printf("network: player %d on port %d\n", lockstep.localPeer + 1,
+                session->getPort());
+  }
+
+  Game game(battle, worldSize, map);
+  if (replay) {
+    game.playReplay(std::move(replay), speed);
+  } else if (!recordPath.empty()) {
+    game.recordTo(recordPath);
+  }
+  if (session)
+    game.playOnline(std::move(session), seed);
+  if (spectatorPort >= 0) {
+    std::unique_ptr<SpectatorServer> server(new SpectatorServer());
+    if (!server->listenTcp(static_cast<std::uint16_t>(spectatorPort))) {
+      std::perror("cannot listen for spectators");
+      return 1;
+    }
+    std::printf("spectators: port %d\n", server->getTcpPort());
+    game.broadcastTo(std::move(server));
+  }
+  if (!profilePath.empty())
+    game.profileTo(profilePath);
   game.run();
   return 0;
 }
@@ -0,0 +1,248 @@
+#include "Lockstep.hpp"
+#include "../game/InputCodec.hpp"
+#include "../utils/BinaryIO.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr std::uint8_t PACKET_MAGIC = 'L';
+// Больше за раз не шлем: после долгого обрыва ввод уходит по частям
+constexpr int MAX_INPUTS_PER_PACKET = 64;
+// Повтор без нового ввода: простой или обрыв связи
+constexpr double RESEND_INTERVAL = 0.05;
+// Сколько своих контрольных сумм помним для сверки с отстающими
+constexpr int CHECKSUM_HISTORY = 256;
+} // namespace
+
+LockstepSession::LockstepSession(const LockstepConfig &config)
+    : link(socket, config.link,
+           RandomStream(config.linkSeed).split(config.localPeer)),
+      localPort(config.port), localPeer(config.localPeer),
+      inputDelay(std::max(1, config.inputDelay)),
+      tickDuration(config.tickDuration), peers(config.peers.size()),
+      submitTimes(inputDelay, -1.0), tick(0), checksums(CHECKSUM_HISTORY, 0),
+      desyncTick(-1) {
+  // Первые inputDelay тиков пустые у всех, их не нужно пересылать
+  for (std::size_t i = 0; i < peers.size(); i++) {
+    peers[i].address = config.peers[i];
+    peers[i].inputs.assign(inputDelay, PlayerInput());
+    peers[i].acked = inputDelay;
+    peers[i].sendFrom = inputDelay;
+    peers[i].lastSentEnd = inputDelay;
+  }
+}
+
+bool LockstepSession::open() { return socket.open(localPort); }
+
+bool LockstepSession::ready() const {
+  for (const Peer &peer : peers) {
+    if (peer.inputEnd() <= tick)
+      return false;
+  }
+  return true;
+}
+
+const PlayerInput &LockstepSession::inputOf(int peer) const {
+  return peers[peer].inputs[tick - peers[peer].inputBase];
+}
+
+void LockstepSession::advance(const PlayerInput &local,
+                              std::uint64_t checksum, double now) {
+  checksums[tick % CHECKSUM_HISTORY] = static_cast<std::uint32_t>(checksum);
+  for (Peer &peer : peers) {
+    if (peer.aheadChecksumTick == tick) {
+      compareChecksum(tick, peer.aheadChecksum);
+      peer.aheadChecksumTick = -1;
+    }
+  }
+
+  peers[localPeer].inputs.push_back(local);
+  submitTimes.push_back(now);
+  tick++;
+  trim();
+}
+
+void LockstepSession::receivePackets(double now) {
+  NetAddress from;
+  while (socket.receive(packet, from))
+    receive(from, now);
+}
+
+void LockstepSession::sendPackets(double now) {
+  const Peer &self = peers[localPeer];
+  for (int i = 0; i < getPeerCount(); i++) {
+    Peer &peer = peers[i];
+    if (i == localPeer || peer.address.port == 0)
+      continue;
+    // Подтверждение обычно едет в пакете со следующим тиком ввода, отдельно
+    // его шлем, только если свой тик задерживается
+    double idle = now - peer.lastSendTime;
+    if (self.inputEnd() > peer.lastSentEnd ||
+        (peer.receivedInputs && idle >= tickDuration) ||
+        idle >= RESEND_INTERVAL)
+      send(i, now);
+  }
+  link.flush(now);
+}
+
+void LockstepSession::send(int peerIndex, double now) {
+  Peer &peer = peers[peerIndex];
+  const Peer &self = peers[localPeer];
+  int first = peer.acked;
+  int count = std::min(self.inputEnd() - first, MAX_INPUTS_PER_PACKET);
+
+  ByteWriter out;
+  out.u8(PACKET_MAGIC);
+  out.u8(static_cast<std::uint8_t>(localPeer));
+  out.varint(first);
+  out.svarint(peer.inputEnd() - first);
+  out.varint(count);
+  // trim() держит ввод с тика перед первым неподтвержденным
+  InputEncoder encoder(first > 0 ? self.inputs[first - 1 - self.inputBase]
+                                 : PlayerInput());
+  for (int i = 0; i < count; i++)
+    encoder.add(out, self.inputs[first + i - self.inputBase]);
+  encoder.flush(out);
+  out.svarint(first - (tick - 1));
+  out.u32(tick > 0 ? checksums[(tick - 1) % CHECKSUM_HISTORY] : 0);
+
+  link.send(peer.address, out.data(), now);
+  stats.packetsSent++;
+  stats.bytesSent += out.size();
+  peer.lastSentEnd = self.inputEnd();
+  peer.lastSendTime = now;
+  peer.receivedInputs = false;
+}
+
+void LockstepSession::receive(const NetAddress &from, double now) {
+  ByteReader in(packet.data(), packet.size());
+  std::uint8_t magic = in.u8();
+  int sender = in.u8();
+  if (!in.ok() || magic != PACKET_MAGIC || sender == localPeer ||
+      sender >= getPeerCount()) {
+    stats.badPackets++;
+    return;
+  }
+  Peer &peer = peers[sender];
+  if (peer.address.port == 0) {
+    peer.address = from;
+  } else if (!(peer.address == from)) {
+    stats.badPackets++;
+    return;
+  }
+
+  Peer &self = peers[localPeer];
+  std::int64_t first = static_cast<std::int64_t>(in.varint());
+  std::int64_t ack = first + in.svarint();
+  std::uint64_t count = in.varint();
+  if (!in.ok() || first > peer.inputEnd() || ack < peer.acked ||
+      ack > self.inputEnd() || count > MAX_INPUTS_PER_PACKET) {
+    // Опоздавший пакет подтверждает меньше, чем уже подтверждено: его
+    // ввод и сумма давно пришли в следующих пакетах
+    if (in.ok() && ack < peer.acked && first <= peer.inputEnd())
+      return;
+    stats.badPackets++;
+    return;
+  }
+
+  // Без ввода перед первым тиком пакет не раскодировать; до такого тика
+  // отправитель уже не опускается, значит, ничего нового в пакете нет
+  int firstTick = static_cast<int>(first);
+  bool decodable = firstTick == 0 || firstTick - 1 >= peer.inputBase;
+  InputDecoder decoder(firstTick > 0 && decodable
+                           ? peer.inputs[firstTick - 1 - peer.inputBase]
+                           : PlayerInput());
+  std::vector<PlayerInput> inputs(count);
+  for (PlayerInput &input : inputs) {
+    if (!decoder.next(in, input)) {
+      // Целый пакет с вводом вне пределов не искажение в пути: участник
+      // сломан или играет другую партию, дальше с ним не сойтись
+      if (in.ok() && desyncTick < 0)
+        desyncTick = tick;
+      stats.badPackets++;
+      return;
+    }
+  }
+  std::int64_t checksumTick = first - in.svarint();
+  std::uint32_t checksum = in.u32();
+  if (!in.ok()) {
+    stats.badPackets++;
+    return;
+  }
+  stats.packetsReceived++;
+  stats.bytesReceived += packet.size();
+
+  // Время до подтверждения последнего тика: дорога туда и обратно плюс
+  // ожидание ответного пакета. Сглаживание как у RTT в TCP.
+  if (ack > peer.acked) {
+    double submitted = submitTimes[ack - 1 - self.inputBase];
+    if (submitted >= 0.0) {
+      float sample = static_cast<float>(now - submitted);
+      if (stats.roundTrip == 0.0f) {
+        stats.roundTrip = sample;
+        stats.roundTripDeviation = sample / 2.0f;
+      } else {
+        stats.roundTripDeviation +=
+            (std::abs(sample - stats.roundTrip) - stats.roundTripDeviation) /
+            4.0f;
+        stats.roundTrip += (sample - stats.roundTrip) / 8.0f;
+      }
+      float oneWay = stats.roundTrip / 2.0f + 2.0f * stats.roundTripDeviation;
+      stats.suggestedDelay =
+          1 + static_cast<int>(std::ceil(oneWay / tickDuration));
+    }
+    peer.acked = static_cast<int>(ack);
+  }
+
+  if (decodable) {
+    for (int i = peer.inputEnd() - firstTick; i < static_cast<int>(count);
+         i++) {
+      peer.inputs.push_back(inputs[i]);
+      peer.receivedInputs = true;
+    }
+  }
+  peer.sendFrom = std::max(peer.sendFrom, firstTick);
+
+  if (checksumTick >= 0) {
+    if (checksumTick < tick) {
+      compareChecksum(static_cast<int>(checksumTick), checksum);
+    } else if (peer.aheadChecksumTick < 0) {
+      peer.aheadChecksumTick = static_cast<int>(checksumTick);
+      peer.aheadChecksum = checksum;
+    }
+  }
+  trim();
+}
+
+void LockstepSession::compareChecksum(int tickNumber, std::uint32_t remote) {
+  if (tickNumber < tick - CHECKSUM_HISTORY ||
+      (desyncTick >= 0 && desyncTick <= tickNumber))
+    return;
+  if (checksums[tickNumber % CHECKSUM_HISTORY] != remote)
+    desyncTick = tickNumber;
+}
+
+void LockstepSession::trim() {
+  // Чужой ввод нужен с текущего тика и с тика перед первым, от которого
+  // участник еще может прислать пакет
+  int localKeep = tick;
+  for (int i = 0; i < getPeerCount(); i++) {
+    if (i == localPeer)
+      continue;
+    Peer &peer = peers[i];
+    int keep = std::min(tick, peer.sendFrom - 1);
+    while (peer.inputBase < keep) {
+      peer.inputs.pop_front();
+      peer.inputBase++;
+    }
+    localKeep = std::min(localKeep, peer.acked - 1);
+  }
+
+  // Свой — пока его не подтвердили все: он основа кодирования пакетов
+  Peer &self = peers[localPeer];
+  while (self.inputBase < localKeep) {
+    self.inputs.pop_front();
+    submitTimes.pop_front();
+    self.inputBase++;
+  }
+}
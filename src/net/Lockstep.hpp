@@ -0,0 +1,134 @@
+#pragma once
+#include "../game/PlayerInput.hpp"
+#include "../utils/GameTypes.hpp"
+#include "UdpSocket.hpp"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct LockstepConfig {
+  int localPeer = 0;
+  // Адреса участников по номерам, свой не используется. Порт 0 — адрес
+  // неизвестен и берется из первого пакета участника (ждущая сторона).
+  std::vector<NetAddress> peers;
+  std::uint16_t port = 0; // свой порт, 0 — любой свободный
+  // Через сколько тиков исполняется ввод: запас на дорогу по сети
+  int inputDelay = 3;
+  float tickDuration = 1.0f / GameTypes::SIM_TICK_RATE;
+  LinkConditions link;
+  std::uint64_t linkSeed = 0; // потери и задержки LinkShim
+};
+
+struct LockstepStats {
+  std::uint64_t packetsSent = 0;
+  std::uint64_t packetsReceived = 0;
+  std::uint64_t bytesSent = 0; // полезная нагрузка, без заголовков UDP/IP
+  std::uint64_t bytesReceived = 0;
+  std::uint64_t badPackets = 0;
+  float roundTrip = 0.0f; // сглаженное время до подтверждения ввода, с
+  float roundTripDeviation = 0.0f;
+  // Задержка ввода, при которой ввод обычно успевает к своему тику
+  int suggestedDelay = 0;
+};
+
+// Сеанс lockstep: все участники исполняют одни и те же тики с одним и тем
+// же вводом, а детерминированная симуляция сама приходит в одно состояние,
+// так что по сети ходит только ввод.
+//
+// Каждый участник шлет свой ввод на inputDelay тиков вперед: ввод после
+// тика t исполняется на тике t + inputDelay. Следующий тик можно исполнять,
+// когда ready(): ввод всех участников для него уже пришел. Первые
+// inputDelay тиков у всех пустые. Команды раздаются участникам по кругу,
+// тик управляется вводом владельца команды активного червяка.
+//
+// Пакет (числа — LEB128, s — зигзаг):
+//
+//   'L', отправитель (u8), первый тик (v), подтверждение - первый тик (s),
+//   число тиков (v), ввод в кодировке InputEncoder, первый тик - тик
+//   контрольной суммы (s), младшие 32 бита Simulation::checksum() (u32)
+//
+// Ввод идет от последнего подтвержденного тика, поэтому потерянный пакет
+// не надо переспрашивать: следующий пакет повторит все, что не дошло. При
+// простое пакеты повторяются по таймеру. Подтверждение — сколько тиков
+// ввода получателя у отправителя есть подряд. Обычно пакет несет тик или
+// два ввода и весит около 12 байт.
+//
+// Сверяется контрольная сумма, которую участник снял после последнего
+// исполненного тика; первое расхождение запоминается в getDesyncTick().
+class LockstepSession {
+public:
+  explicit LockstepSession(const LockstepConfig &config);
+
+  bool open();
+  std::uint16_t getPort() const { return socket.getPort(); }
+  // Для участников, чей порт стал известен после создания сеанса
+  void setPeerAddress(int peer, const NetAddress &address) {
+    peers[peer].address = address;
+  }
+
+  // now — время в секундах от любого начала отсчета, одного для всех
+  // вызовов. Принимать пакеты лучше перед тиками кадра, а отправлять после
+  // них: тогда свежий ввод уходит в том же кадре одним пакетом.
+  void receivePackets(double now);
+  // Свой новый ввод, подтверждения полученного и повтор при простое
+  void sendPackets(double now);
+
+  bool ready() const;
+  int getTick() const { return tick; }
+  int getPeerCount() const { return static_cast<int>(peers.size()); }
+  int getLocalPeer() const { return localPeer; }
+  int ownerOf(int team) const { return team % getPeerCount(); }
+  // Ввод участника на текущий тик; вызывать, когда ready()
+  const PlayerInput &inputOf(int peer) const;
+
+  // Текущий тик исполнен. checksum — Simulation::checksum() после него,
+  // local — свой ввод для тика getTick() + inputDelay (до перехода).
+  void advance(const PlayerInput &local, std::uint64_t checksum, double now);
+
+  // Первый тик, после которого контрольные суммы разошлись или пришел
+  // недопустимый ввод; -1 — нет
+  int getDesyncTick() const { return desyncTick; }
+  const LockstepStats &getStats() const { return stats; }
+
+private:
+  struct Peer {
+    NetAddress address;
+    // Ввод с тика inputBase подряд; у себя — отправленный ввод
+    std::deque<PlayerInput> inputs;
+    int inputBase = 0;
+    // Сколько тиков нашего ввода у участника есть подряд
+    int acked = 0;
+    // Наибольший первый тик в его пакетах: раньше он слать уже не станет
+    int sendFrom = 0;
+    int lastSentEnd = 0;
+    double lastSendTime = -1.0;
+    bool receivedInputs = false; // новый ввод: ответить подтверждением
+    // Сумма тика, до которого мы еще не дошли
+    int aheadChecksumTick = -1;
+    std::uint32_t aheadChecksum = 0;
+
+    int inputEnd() const {
+      return inputBase + static_cast<int>(inputs.size());
+    }
+  };
+
+  void receive(const NetAddress &from, double now);
+  void send(int peer, double now);
+  void compareChecksum(int tickNumber, std::uint32_t remote);
+  void trim();
+
+  UdpSocket socket;
+  LinkShim link;
+  std::uint16_t localPort;
+  int localPeer;
+  int inputDelay;
+  float tickDuration;
+  std::vector<Peer> peers;
+  std::deque<double> submitTimes; // время отправки своего ввода по тикам
+
+  int tick;
+  std::vector<std::uint32_t> checksums; // свои суммы по кругу
+  int desyncTick;
+  LockstepStats stats;
+  std::vector<std::uint8_t> packet;
+};
@@ -0,0 +1,342 @@
+#include "Spectator.hpp"
+#include "../terrain/MapFile.hpp"
+#include "../terrain/SurfaceIndex.hpp"
+#include "../utils/Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+enum FrameType : std::uint8_t { DELTA_FRAME = 1, KEY_FRAME = 2 };
+
+enum StateFlags : std::uint8_t {
+  TURN = 1,
+  TIMER = 2,
+  WEAPON = 4,
+  GAME_OVER = 8,
+};
+
+// Кадр длиннее — явно не наш поток
+constexpr std::uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+constexpr std::uint64_t MAX_WORLD_WIDTH = SurfaceIndex::MAX_WIDTH;
+constexpr std::uint64_t MAX_WORLD_HEIGHT = SurfaceIndex::MAX_HEIGHT;
+
+bool sameBits(sf::Vector2f a, sf::Vector2f b) {
+  return std::memcmp(&a.x, &b.x, sizeof(float)) == 0 &&
+         std::memcmp(&a.y, &b.y, sizeof(float)) == 0;
+}
+
+void writeWorm(ByteWriter &out, std::size_t index,
+               const SpectatorState::WormState &worm) {
+  out.varint(index);
+  out.f32(worm.position.x);
+  out.f32(worm.position.y);
+  out.varint(static_cast<std::uint32_t>(std::max(worm.health, 0)));
+  out.varint(static_cast<std::uint32_t>(worm.team) * 2 +
+             (worm.active ? 1 : 0));
+}
+
+void writeProjectiles(ByteWriter &out, const SpectatorState &state) {
+  out.varint(state.projectiles.size());
+  for (const auto &projectile : state.projectiles) {
+    out.u8(static_cast<std::uint8_t>(projectile.type));
+    out.f32(projectile.position.x);
+    out.f32(projectile.position.y);
+  }
+}
+
+// Тот же формат, что у TerrainManager::writeDestructions, но для отрезка
+// журнала: читается через TerrainManager::readDestructions
+void writeDestructions(ByteWriter &out,
+                       const std::vector<TerrainDestruction> &journal,
+                       std::size_t from, std::size_t to) {
+  out.varint(to - from);
+  for (std::size_t i = from; i < to; i++) {
+    out.svarint(journal[i].centerX);
+    out.svarint(journal[i].centerY);
+    out.varint(static_cast<std::uint32_t>(journal[i].radius));
+  }
+}
+
+// Длина впереди тела: кадр целиком уходит в сокет без доработки
+SharedFrame finishFrame(const ByteWriter &body) {
+  std::vector<std::uint8_t> frame;
+  frame.reserve(4 + body.size());
+  std::uint32_t size = static_cast<std::uint32_t>(body.size());
+  for (int i = 0; i < 4; i++)
+    frame.push_back(static_cast<std::uint8_t>(size >> (8 * i)));
+  frame.insert(frame.end(), body.data().begin(), body.data().end());
+  return std::make_shared<const std::vector<std::uint8_t>>(std::move(frame));
+}
+} // namespace
+
+SpectatorEncoder::SpectatorEncoder()
+    : destructionsSent(0), mapVersion(0), started(false),
+      lastKeyframe(false) {}
+
+SharedFrame SpectatorEncoder::encodeTick(const Simulation &simulation) {
+  cachedKeyframe.reset();
+  const TerrainManager &terrain = simulation.getTerrain();
+  // Новый матч: изменения считать не от чего, все зрители получат
+  // ключевой кадр
+  bool newMatch = !started || terrain.getMapVersion() != mapVersion ||
+                  simulation.getWorms().size() != sent.worms.size();
+  if (newMatch) {
+    started = true;
+    mapVersion = terrain.getMapVersion();
+    sent = SpectatorState();
+    sent.worms.resize(simulation.getWorms().size());
+    destructionsSent = 0;
+  }
+
+  sent.tick++;
+  std::uint8_t flags = 0;
+  int turnDeciseconds =
+      static_cast<int>(std::floor(simulation.getTurnTime() * 10.0f));
+  if (simulation.getCurrentPlayer() != sent.currentPlayer)
+    flags |= TURN;
+  if (turnDeciseconds != sent.turnDeciseconds)
+    flags |= TIMER;
+  if (simulation.getCurrentWeapon() != sent.weapon)
+    flags |= WEAPON;
+  if (simulation.isGameOver() != sent.gameOver)
+    flags |= GAME_OVER;
+  sent.currentPlayer = simulation.getCurrentPlayer();
+  sent.turnDeciseconds = turnDeciseconds;
+  sent.weapon = simulation.getCurrentWeapon();
+  sent.gameOver = simulation.isGameOver();
+  sent.winner = simulation.getWinner();
+
+  ByteWriter body;
+  body.u8(DELTA_FRAME);
+  body.varint(sent.tick);
+  body.u8(flags);
+  if (flags & TURN)
+    body.varint(sent.currentPlayer);
+  if (flags & TIMER)
+    body.varint(sent.turnDeciseconds);
+  if (flags & WEAPON)
+    body.u8(static_cast<std::uint8_t>(sent.weapon));
+  if (flags & GAME_OVER)
+    body.svarint(sent.winner);
+
+  // Только червяки, которые сдвинулись, получили урон или погибли
+  ByteWriter worms;
+  std::size_t changed = 0;
+  for (std::size_t i = 0; i < sent.worms.size(); i++) {
+    const Worm &worm = simulation.getWorms()[i];
+    SpectatorState::WormState &known = sent.worms[i];
+    if (!newMatch && sameBits(worm.position, known.position) &&
+        worm.health == known.health && worm.isActive == known.active)
+      continue;
+    known = {worm.position, worm.health, worm.teamId, worm.isActive};
+    writeWorm(worms, i, known);
+    changed++;
+  }
+  body.varint(changed);
+  body.bytes(worms.data().data(), worms.size());
+
+  sent.projectiles.clear();
+  const ProjectilePool &projectiles = simulation.getProjectiles();
+  for (std::uint32_t slot : projectiles.getLiveSlots()) {
+    if (projectiles.activeFlags[slot])
+      sent.projectiles.push_back(
+          {projectiles.weaponTypes[slot], projectiles.positions[slot]});
+  }
+  writeProjectiles(body, sent);
+
+  const std::vector<TerrainDestruction> &journal = terrain.getDestructions();
+  writeDestructions(body, journal, destructionsSent, journal.size());
+  destructionsSent = journal.size();
+
+  lastKeyframe = newMatch;
+  return newMatch ? keyframe(simulation) : finishFrame(body);
+}
+
+SharedFrame SpectatorEncoder::keyframe(const Simulation &simulation) {
+  if (!started || simulation.getTerrain().getMapVersion() != mapVersion)
+    return nullptr;
+  if (!cachedKeyframe) {
+    ByteWriter body;
+    body.u8(KEY_FRAME);
+    encodeKeyframe(body, simulation);
+    cachedKeyframe = finishFrame(body);
+  }
+  return cachedKeyframe;
+}
+
+void SpectatorEncoder::encodeKeyframe(ByteWriter &body,
+                                      const Simulation &simulation) const {
+  // Состояние берется из sent, а не из симуляции: ключевой кадр обязан
+  // совпадать с последним тиком, который получили остальные зрители.
+  // Из симуляции — только заголовок и начало журнала разрушений.
+  const TerrainManager &terrain = simulation.getTerrain();
+  body.varint(sent.tick);
+  body.u64(simulation.getSeed());
+  body.varint(static_cast<std::uint32_t>(terrain.getWidth()));
+  body.varint(static_cast<std::uint32_t>(terrain.getHeight()));
+  const BattleConfig &battle = simulation.getBattle();
+  body.varint(static_cast<std::uint32_t>(battle.teams));
+  body.varint(static_cast<std::uint32_t>(battle.wormsPerTeam));
+  body.string(terrain.getSource() ? terrain.getSource()->getPath() : "");
+
+  body.u8(TURN | TIMER | WEAPON | (sent.gameOver ? GAME_OVER : 0));
+  body.varint(sent.currentPlayer);
+  body.varint(sent.turnDeciseconds);
+  body.u8(static_cast<std::uint8_t>(sent.weapon));
+  if (sent.gameOver)
+    body.svarint(sent.winner);
+
+  body.varint(sent.worms.size());
+  for (std::size_t i = 0; i < sent.worms.size(); i++)
+    writeWorm(body, i, sent.worms[i]);
+  writeProjectiles(body, sent);
+  writeDestructions(body, terrain.getDestructions(), 0, destructionsSent);
+}
+
+SpectatorView::SpectatorView(bool withTerrain)
+    : withTerrain(withTerrain), keyed(false), terrainSeed(0),
+      framesApplied(0) {}
+
+bool SpectatorView::receive(const std::uint8_t *data, std::size_t size) {
+  pending.insert(pending.end(), data, data + size);
+  std::size_t offset = 0;
+  while (pending.size() - offset >= 4) {
+    std::uint32_t frameSize = 0;
+    for (int i = 0; i < 4; i++)
+      frameSize |= static_cast<std::uint32_t>(pending[offset + i]) << (8 * i);
+    if (frameSize > MAX_FRAME_SIZE)
+      return false;
+    if (pending.size() - offset - 4 < frameSize)
+      break;
+    if (!applyFrame(pending.data() + offset + 4, frameSize))
+      return false;
+    offset += 4 + frameSize;
+  }
+  pending.erase(pending.begin(), pending.begin() + offset);
+  return true;
+}
+
+bool SpectatorView::applyFrame(const std::uint8_t *data, std::size_t size) {
+  ByteReader in(data, size);
+  std::uint8_t type = in.u8();
+  std::uint64_t tick = in.varint();
+  if (type != KEY_FRAME && type != DELTA_FRAME)
+    return false;
+  // До первого ключевого кадра изменения прикладывать не к чему
+  if (type == DELTA_FRAME && !keyed)
+    return true;
+
+  SpectatorState next = state;
+  std::uint64_t seed = 0, width = 0, height = 0;
+  std::string mapPath;
+  if (type == KEY_FRAME) {
+    seed = in.u64();
+    width = in.varint();
+    height = in.varint();
+    in.varint(); // команды и червяки в команде — для справки зрителю
+    in.varint();
+    mapPath = in.string();
+    if (!in.ok() || width == 0 || height == 0 || width > MAX_WORLD_WIDTH ||
+        height > MAX_WORLD_HEIGHT)
+      return false;
+    next = SpectatorState();
+  }
+  next.tick = static_cast<int>(tick);
+
+  std::uint8_t flags = in.u8();
+  if (flags & TURN)
+    next.currentPlayer = static_cast<int>(in.varint());
+  if (flags & TIMER)
+    next.turnDeciseconds = static_cast<int>(in.varint());
+  if (flags & WEAPON) {
+    std::uint8_t weapon = in.u8();
+    if (weapon >= GameTypes::WEAPON_COUNT)
+      return false;
+    next.weapon = static_cast<GameTypes::WeaponType>(weapon);
+  }
+  if (flags & GAME_OVER) {
+    next.gameOver = true;
+    next.winner = static_cast<int>(in.svarint());
+  }
+
+  // Запись червяка занимает хотя бы 11 байт
+  std::uint64_t worms = in.varint();
+  if (!in.ok() || worms > in.remaining() / 11)
+    return false;
+  if (type == KEY_FRAME)
+    next.worms.resize(worms);
+  for (std::uint64_t i = 0; i < worms; i++) {
+    std::uint64_t index = in.varint();
+    if (index >= next.worms.size())
+      return false;
+    SpectatorState::WormState &worm = next.worms[index];
+    worm.position.x = in.f32();
+    worm.position.y = in.f32();
+    worm.health = static_cast<int>(in.varint());
+    std::uint64_t teamAndLife = in.varint();
+    worm.team = static_cast<int>(teamAndLife >> 1);
+    worm.active = (teamAndLife & 1) != 0;
+  }
+  if (next.currentPlayer < 0 ||
+      next.currentPlayer >= static_cast<int>(next.worms.size()))
+    return false;
+
+  std::uint64_t projectiles = in.varint();
+  if (!in.ok() || projectiles > in.remaining() / 9)
+    return false;
+  next.projectiles.resize(projectiles);
+  for (SpectatorState::ProjectileState &projectile : next.projectiles) {
+    std::uint8_t weapon = in.u8();
+    if (weapon >= GameTypes::WEAPON_COUNT)
+      return false;
+    projectile.type = static_cast<GameTypes::WeaponType>(weapon);
+    projectile.position.x = in.f32();
+    projectile.position.y = in.f32();
+  }
+
+  std::vector<TerrainDestruction> destructions;
+  if (!TerrainManager::readDestructions(in, destructions) || !in.ok())
+    return false;
+
+  if (type == KEY_FRAME && withTerrain) {
+    // На той же карте достаточно доложить новые разрушения; карту строим
+    // заново, только если она другая или журнал не продолжает наш
+    bool sameMap = terrain && terrainSeed == seed && terrainMap == mapPath &&
+                   terrain->getWidth() == static_cast<int>(width) &&
+                   terrain->getHeight() == static_cast<int>(height);
+    if (!sameMap || !terrain->catchUp(destructions)) {
+      if (!resetTerrain(seed, static_cast<int>(width),
+                        static_cast<int>(height), mapPath))
+        return false;
+      terrain->catchUp(destructions);
+    }
+  } else if (terrain) {
+    for (const TerrainDestruction &d : destructions)
+      terrain->destroyTerrain(d.centerX, d.centerY, d.radius);
+  }
+
+  state = std::move(next);
+  keyed = true;
+  framesApplied++;
+  return true;
+}
+
+bool SpectatorView::resetTerrain(std::uint64_t seed, int width, int height,
+                                 const std::string &mapPath) {
+  // Карта без разрушений, как ее строит Simulation
+  if (mapPath.empty()) {
+    terrain.reset(new TerrainManager(
+        width, height, RandomStream(seed).split(RandomStreams::TERRAIN)));
+  } else {
+    auto map = std::make_shared<MapFile>();
+    if (!map->open(mapPath) || map->getWidth() != width ||
+        map->getHeight() != height)
+      return false;
+    terrain.reset(new TerrainManager(map));
+  }
+  terrainSeed = seed;
+  terrainMap = mapPath;
+  return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "../game/Simulation.hpp"
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/BinaryIO.hpp"
+#include "../utils/GameTypes.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Готовый кадр трансляции: кодируется один раз и разделяется всеми
+// зрителями, пока последний не дочитает
+using SharedFrame = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+// Все, что зритель знает о матче: хватает, чтобы нарисовать кадр
+struct SpectatorState {
+  struct WormState {
+    sf::Vector2f position;
+    int health = 0;
+    int team = 0;
+    bool active = false;
+  };
+  struct ProjectileState {
+    GameTypes::WeaponType type = GameTypes::WeaponType::BAZOOKA;
+    sf::Vector2f position;
+  };
+
+  int tick = 0;
+  std::vector<WormState> worms;
+  std::vector<ProjectileState> projectiles;
+  int currentPlayer = 0;
+  int turnDeciseconds = 0; // время хода с точностью до десятой секунды
+  GameTypes::WeaponType weapon = GameTypes::WeaponType::BAZOOKA;
+  bool gameOver = false;
+  int winner = -1;
+};
+
+// Кодирование трансляции матча. Кадр — длина (u32) и тело; числа
+// little-endian, v — LEB128, s — зигзаг:
+//
+//   тип (u8: 1 — изменения, 2 — ключевой), тик (v)
+//   ключевой: seed (u64), ширина, высота, команды, червяки (v), путь к
+//     карте (строка)
+//   флаги (u8) и по ним: ход (v), время хода в 0.1 с (v), оружие (u8),
+//     победитель (s)
+//   червяки (v) и каждый: номер (v), x, y (f32), здоровье (v),
+//     команда * 2 + жив (v)
+//   снаряды (v) и каждый: оружие (u8), x, y (f32)
+//   разрушения (v) и каждое: центр (s, s), радиус (v)
+//
+// Кадр изменений несет только червяков, которые сдвинулись или получили
+// урон, и новые разрушения: местность передается кругами из
+// destroyTerrain, а не пикселями. Снаряды летят каждый тик, их список
+// полный. Ключевой кадр — все состояние, включая журнал разрушений
+// целиком; с него начинает каждый новый зритель.
+class SpectatorEncoder {
+public:
+  SpectatorEncoder();
+
+  // Кадр очередного тика; первый кадр и кадр после смены карты ключевые
+  SharedFrame encodeTick(const Simulation &simulation);
+  bool lastWasKeyframe() const { return lastKeyframe; }
+  // Ключевой кадр последнего закодированного тика для новых зрителей: один
+  // на всех, кто подключился между тиками. nullptr — тиков еще не было или
+  // после последнего сменилась карта.
+  SharedFrame keyframe(const Simulation &simulation);
+
+private:
+  void encodeKeyframe(ByteWriter &body, const Simulation &simulation) const;
+
+  SpectatorState sent;
+  std::size_t destructionsSent;
+  std::uint64_t mapVersion;
+  bool started;
+  bool lastKeyframe;
+  SharedFrame cachedKeyframe;
+};
+
+// Сторона зрителя: собирает кадры из потока байт и применяет их к своему
+// состоянию и своей копии местности. Карта выводится из seed заголовка
+// (или открывается по пути), дальше на нее накладываются разрушения.
+class SpectatorView {
+public:
+  // withTerrain = false — только состояние, без местности (нагрузочные
+  // клиенты, которым карта не нужна)
+  explicit SpectatorView(bool withTerrain = true);
+
+  // Очередная порция потока; false — поток испорчен
+  bool receive(const std::uint8_t *data, std::size_t size);
+  // Один кадр без длины
+  bool applyFrame(const std::uint8_t *data, std::size_t size);
+
+  bool hasKeyframe() const { return keyed; }
+  const SpectatorState &getState() const { return state; }
+  // nullptr, пока не было ключевого кадра или местность не нужна
+  const TerrainManager *getTerrain() const { return terrain.get(); }
+  std::uint64_t getFramesApplied() const { return framesApplied; }
+
+private:
+  bool resetTerrain(std::uint64_t seed, int width, int height,
+                    const std::string &mapPath);
+
+  bool withTerrain;
+  bool keyed;
+  SpectatorState state;
+  std::unique_ptr<TerrainManager> terrain;
+  std::uint64_t terrainSeed;
+  std::string terrainMap;
+  std::vector<std::uint8_t> pending; // начатый кадр
+  std::uint64_t framesApplied;
+};
@@ -0,0 +1,258 @@
+#include "SpectatorServer.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Отставание больше — зритель начинает заново с ключевого кадра
+constexpr std::size_t MAX_QUEUED_FRAMES = 600;
+// Кадров за один sendmsg
+constexpr int MAX_IOVECS = 64;
+constexpr int LISTEN_BACKLOG = 1024;
+
+double secondsSince(Clock::time_point from) {
+  return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+bool setNonBlocking(int handle) {
+  return fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK) == 0;
+}
+} // namespace
+
+SpectatorServer::SpectatorServer()
+    : tcpListener(-1), localListener(-1), tcpPort(0) {}
+
+SpectatorServer::~SpectatorServer() {
+  for (Client &client : clients)
+    close(client.handle);
+  if (tcpListener >= 0)
+    close(tcpListener);
+  if (localListener >= 0) {
+    close(localListener);
+    unlink(localPath.c_str());
+  }
+}
+
+bool SpectatorServer::listenTcp(std::uint16_t port) {
+  int handle = socket(AF_INET, SOCK_STREAM, 0);
+  if (handle < 0)
+    return false;
+  int reuse = 1;
+  setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t length = sizeof(address);
+  if (bind(handle, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+      listen(handle, LISTEN_BACKLOG) != 0 ||
+      getsockname(handle, reinterpret_cast<sockaddr *>(&address), &length) !=
+          0 ||
+      !setNonBlocking(handle)) {
+    close(handle);
+    return false;
+  }
+  tcpListener = handle;
+  tcpPort = ntohs(address.sin_port);
+  return true;
+}
+
+bool SpectatorServer::listenLocal(const std::string &path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+    return false;
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size());
+
+  int handle = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (handle < 0)
+    return false;
+  unlink(path.c_str());
+  if (bind(handle, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+          0 ||
+      listen(handle, LISTEN_BACKLOG) != 0 || !setNonBlocking(handle)) {
+    close(handle);
+    return false;
+  }
+  localListener = handle;
+  localPath = path;
+  return true;
+}
+
+void SpectatorServer::broadcast(const Simulation &simulation) {
+  auto encodeStart = Clock::now();
+  SharedFrame frame = encoder.encodeTick(simulation);
+  stats.ticks++;
+  stats.framesEncoded++;
+  stats.bytesEncoded += frame->size();
+  stats.encodeSeconds += secondsSince(encodeStart);
+
+  // Ключевой кадр для новых и отставших собирается, только если такие есть
+  SharedFrame keyframe;
+  if (encoder.lastWasKeyframe()) {
+    keyframe = frame;
+    countedKeyframe = frame;
+    stats.keyframes++;
+  }
+  auto requireKeyframe = [&]() {
+    if (!keyframe)
+      keyframe = currentKeyframe(simulation);
+  };
+
+  auto fanOutStart = Clock::now();
+  for (Client &client : clients) {
+    if (client.queue.size() >= MAX_QUEUED_FRAMES) {
+      // Начатый кадр дописываем, иначе зритель потеряет границы кадров
+      std::size_t keep = client.offset > 0 ? 1 : 0;
+      while (client.queue.size() > keep) {
+        client.queuedBytes -= client.queue.back()->size();
+        client.queue.pop_back();
+      }
+      client.needsKeyframe = true;
+      stats.resyncs++;
+    }
+    if (client.needsKeyframe) {
+      requireKeyframe();
+      enqueue(client, keyframe);
+      client.needsKeyframe = false;
+    } else {
+      enqueue(client, frame);
+    }
+  }
+  stats.fanOutSeconds += secondsSince(fanOutStart);
+}
+
+SharedFrame SpectatorServer::currentKeyframe(const Simulation &simulation) {
+  auto start = Clock::now();
+  SharedFrame keyframe = encoder.keyframe(simulation);
+  // Кодировщик отдает один кадр на тик, считаем его один раз
+  if (keyframe && keyframe != countedKeyframe) {
+    countedKeyframe = keyframe;
+    stats.framesEncoded++;
+    stats.bytesEncoded += keyframe->size();
+    stats.keyframes++;
+    stats.encodeSeconds += secondsSince(start);
+  }
+  return keyframe;
+}
+
+void SpectatorServer::enqueue(Client &client, const SharedFrame &frame) {
+  client.queue.push_back(frame);
+  client.queuedBytes += frame->size();
+  stats.framesQueued++;
+}
+
+void SpectatorServer::poll(const Simulation &simulation) {
+  auto start = Clock::now();
+  if (tcpListener >= 0)
+    acceptClients(tcpListener, true);
+  if (localListener >= 0)
+    acceptClients(localListener, false);
+
+  SharedFrame keyframe;
+  for (std::size_t i = 0; i < clients.size();) {
+    // Новому зрителю — сразу состояние последнего тика, если оно есть
+    Client &client = clients[i];
+    if (client.needsKeyframe && client.queue.empty()) {
+      if (!keyframe)
+        keyframe = currentKeyframe(simulation);
+      if (keyframe) {
+        enqueue(client, keyframe);
+        client.needsKeyframe = false;
+      }
+    }
+    if (flush(client)) {
+      i++;
+      continue;
+    }
+    close(clients[i].handle);
+    clients[i] = std::move(clients.back());
+    clients.pop_back();
+    stats.disconnected++;
+  }
+  stats.fanOutSeconds += secondsSince(start);
+}
+
+void SpectatorServer::acceptClients(int listener, bool tcp) {
+  for (;;) {
+    int handle = accept(listener, nullptr, nullptr);
+    if (handle < 0)
+      return;
+    if (!setNonBlocking(handle)) {
+      close(handle);
+      continue;
+    }
+    // Кадры мелкие и идут каждый тик: не ждем, пока наберется сегмент
+    if (tcp) {
+      int noDelay = 1;
+      setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+    Client client;
+    client.handle = handle;
+    clients.push_back(std::move(client));
+    stats.accepted++;
+  }
+}
+
+bool SpectatorServer::flush(Client &client) {
+  while (!client.queue.empty()) {
+    iovec parts[MAX_IOVECS];
+    int count = 0;
+    std::size_t requested = 0;
+    for (const SharedFrame &frame : client.queue) {
+      if (count == MAX_IOVECS)
+        break;
+      std::size_t skip = count == 0 ? client.offset : 0;
+      parts[count].iov_base = const_cast<std::uint8_t *>(frame->data() + skip);
+      parts[count].iov_len = frame->size() - skip;
+      requested += parts[count].iov_len;
+      count++;
+    }
+
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = parts;
+    message.msg_iovlen = count;
+    ssize_t sent = sendmsg(client.handle, &message, MSG_NOSIGNAL);
+    stats.sendCalls++;
+    if (sent < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    stats.bytesSent += static_cast<std::uint64_t>(sent);
+    std::size_t remaining = static_cast<std::size_t>(sent);
+    while (remaining > 0) {
+      std::size_t left = client.queue.front()->size() - client.offset;
+      if (remaining < left) {
+        client.offset += remaining;
+        break;
+      }
+      remaining -= left;
+      client.queuedBytes -= client.queue.front()->size();
+      client.queue.pop_front();
+      client.offset = 0;
+    }
+    // Сокет взял не все: буфер полон, остальное в следующий раз
+    if (static_cast<std::size_t>(sent) < requested)
+      return true;
+  }
+  return true;
+}
+
+std::size_t SpectatorServer::getQueuedBytes() const {
+  std::size_t bytes = 0;
+  for (const Client &client : clients)
+    bytes += client.queuedBytes - client.offset;
+  return bytes;
+}
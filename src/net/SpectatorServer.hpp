@@ -0,0 +1,84 @@
+#pragma once
+#include "../game/Simulation.hpp"
+#include "Spectator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+struct SpectatorServerStats {
+  std::uint64_t ticks = 0;
+  std::uint64_t framesEncoded = 0; // по одному на тик плюс ключевые
+  std::uint64_t bytesEncoded = 0;
+  std::uint64_t keyframes = 0;
+  std::uint64_t framesQueued = 0; // ссылок на кадры в очередях зрителей
+  std::uint64_t bytesSent = 0;
+  std::uint64_t sendCalls = 0;
+  std::uint64_t accepted = 0;
+  std::uint64_t disconnected = 0;
+  std::uint64_t resyncs = 0; // отставшие зрители, начатые заново с ключевого
+  double encodeSeconds = 0.0;
+  double fanOutSeconds = 0.0; // постановка в очереди и отправка
+};
+
+// Сервер трансляции матча зрителям по TCP или локальному сокету (Unix).
+// Кадр каждого тика кодируется один раз, а в очередь каждого зрителя
+// ставится ссылка на него: отправка стоит одного вызова sendmsg на
+// зрителя за все накопившиеся кадры, без повторной сериализации. Новые
+// зрители начинают с ключевого кадра, одного на всех подключившихся за
+// тик.
+//
+// Зрители ничего не присылают. Кто не успевает забирать поток, того
+// очередь обрезается (кроме начатого кадра) и он начинает заново с
+// ключевого кадра, так что память сервера не растет из-за медленных
+// клиентов. Однопоточный: все вызовы из одного потока.
+class SpectatorServer {
+public:
+  SpectatorServer();
+  ~SpectatorServer();
+  SpectatorServer(const SpectatorServer &) = delete;
+  SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+  // port 0 — любой свободный, узнать его можно через getTcpPort()
+  bool listenTcp(std::uint16_t port);
+  // Локальный сокет по пути path; старый файл сокета удаляется
+  bool listenLocal(const std::string &path);
+  std::uint16_t getTcpPort() const { return tcpPort; }
+
+  // Очередной тик матча: вызывать после каждого Simulation::step
+  void broadcast(const Simulation &simulation);
+  // Прием новых зрителей и отправка очередей; вызывать хотя бы раз за
+  // кадр игры, можно чаще. Новый зритель сразу получает ключевой кадр
+  // последнего тика.
+  void poll(const Simulation &simulation);
+
+  std::size_t getClientCount() const { return clients.size(); }
+  // Байт в очередях всех зрителей: 0 — все догнали поток
+  std::size_t getQueuedBytes() const;
+  const SpectatorServerStats &getStats() const { return stats; }
+
+private:
+  struct Client {
+    int handle = -1;
+    std::deque<SharedFrame> queue;
+    std::size_t offset = 0; // отправлено от первого кадра очереди
+    std::size_t queuedBytes = 0;
+    bool needsKeyframe = true;
+  };
+
+  void acceptClients(int listener, bool tcp);
+  // false — зритель отключился
+  bool flush(Client &client);
+  void enqueue(Client &client, const SharedFrame &frame);
+  SharedFrame currentKeyframe(const Simulation &simulation);
+
+  SpectatorEncoder encoder;
+  SharedFrame countedKeyframe; // последний учтенный в статистике
+  int tcpListener;
+  int localListener;
+  std::uint16_t tcpPort;
+  std::string localPath;
+  std::vector<Client> clients;
+  SpectatorServerStats stats;
+};
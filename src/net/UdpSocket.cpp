@@ -0,0 +1,146 @@
+#include "UdpSocket.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// Больше не бывает: пакеты протокола укладываются в MTU с запасом
+constexpr std::size_t MAX_PACKET_SIZE = 2048;
+
+sockaddr_in toSockaddr(const NetAddress &address) {
+  sockaddr_in result;
+  std::memset(&result, 0, sizeof(result));
+  result.sin_family = AF_INET;
+  result.sin_addr.s_addr = htonl(address.host);
+  result.sin_port = htons(address.port);
+  return result;
+}
+} // namespace
+
+bool NetAddress::parse(const std::string &text, NetAddress &address) {
+  std::size_t colon = text.rfind(':');
+  if (colon == std::string::npos || colon == 0 || colon + 1 == text.size())
+    return false;
+  std::string host = text.substr(0, colon);
+  char *end = nullptr;
+  long port = std::strtol(text.c_str() + colon + 1, &end, 10);
+  if (*end != '\0' || port <= 0 || port > 65535)
+    return false;
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo *found = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || !found)
+    return false;
+  const sockaddr_in *resolved =
+      reinterpret_cast<const sockaddr_in *>(found->ai_addr);
+  address.host = ntohl(resolved->sin_addr.s_addr);
+  address.port = static_cast<std::uint16_t>(port);
+  freeaddrinfo(found);
+  return true;
+}
+
+std::string NetAddress::toString() const {
+  return std::to_string(host >> 24) + "." +
+         std::to_string((host >> 16) & 0xff) + "." +
+         std::to_string((host >> 8) & 0xff) + "." +
+         std::to_string(host & 0xff) + ":" + std::to_string(port);
+}
+
+UdpSocket::UdpSocket() : handle(-1), port(0) {}
+
+UdpSocket::~UdpSocket() { close(); }
+
+bool UdpSocket::open(std::uint16_t localPort) {
+  close();
+  handle = socket(AF_INET, SOCK_DGRAM, 0);
+  if (handle < 0)
+    return false;
+
+  NetAddress any;
+  any.port = localPort;
+  sockaddr_in address = toSockaddr(any);
+  socklen_t length = sizeof(address);
+  if (bind(handle, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+      getsockname(handle, reinterpret_cast<sockaddr *>(&address), &length) !=
+          0 ||
+      fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK) != 0) {
+    close();
+    return false;
+  }
+  port = ntohs(address.sin_port);
+  return true;
+}
+
+void UdpSocket::close() {
+  if (handle >= 0)
+    ::close(handle);
+  handle = -1;
+  port = 0;
+}
+
+void UdpSocket::send(const NetAddress &to, const std::uint8_t *data,
+                     std::size_t size) {
+  if (handle < 0)
+    return;
+  sockaddr_in address = toSockaddr(to);
+  sendto(handle, data, size, 0, reinterpret_cast<sockaddr *>(&address),
+         sizeof(address));
+}
+
+bool UdpSocket::receive(std::vector<std::uint8_t> &packet, NetAddress &from) {
+  if (handle < 0)
+    return false;
+  packet.resize(MAX_PACKET_SIZE);
+  sockaddr_in address;
+  socklen_t length = sizeof(address);
+  ssize_t size =
+      recvfrom(handle, packet.data(), packet.size(), 0,
+               reinterpret_cast<sockaddr *>(&address), &length);
+  if (size < 0) {
+    packet.clear();
+    return false;
+  }
+  packet.resize(static_cast<std::size_t>(size));
+  from.host = ntohl(address.sin_addr.s_addr);
+  from.port = ntohs(address.sin_port);
+  return true;
+}
+
+LinkShim::LinkShim(UdpSocket &socket, const LinkConditions &conditions,
+                   RandomStream rng)
+    : socket(socket), conditions(conditions), rng(rng) {}
+
+void LinkShim::send(const NetAddress &to,
+                    const std::vector<std::uint8_t> &packet, double now) {
+  if (conditions.loss > 0.0f && rng.nextFloat() < conditions.loss)
+    return;
+  double delay = conditions.latency +
+                 rng.uniform(-conditions.jitter, conditions.jitter);
+  if (delay <= 0.0) {
+    socket.send(to, packet.data(), packet.size());
+    return;
+  }
+  pending.push_back({now + delay, to, packet});
+}
+
+void LinkShim::flush(double now) {
+  // Порядок отправки — по сроку, а не по очереди вызовов send
+  std::sort(pending.begin(), pending.end(),
+            [](const Pending &a, const Pending &b) { return a.due < b.due; });
+  std::size_t sent = 0;
+  while (sent < pending.size() && pending[sent].due <= now) {
+    socket.send(pending[sent].to, pending[sent].data.data(),
+                pending[sent].data.size());
+    sent++;
+  }
+  pending.erase(pending.begin(), pending.begin() + sent);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "../utils/Random.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Адрес IPv4 и порт в порядке байт хоста
+struct NetAddress {
+  std::uint32_t host = 0;
+  std::uint16_t port = 0;
+
+  // "host:port", host — IPv4 или имя вроде localhost; false — не разобрать
+  static bool parse(const std::string &text, NetAddress &address);
+  std::string toString() const;
+
+  bool operator==(const NetAddress &other) const {
+    return host == other.host && port == other.port;
+  }
+};
+
+// Неблокирующий UDP-сокет. Ошибки отправки не проверяются: для протокола
+// поверх UDP неотправленный пакет ничем не отличается от потерянного.
+class UdpSocket {
+public:
+  UdpSocket();
+  ~UdpSocket();
+  UdpSocket(const UdpSocket &) = delete;
+  UdpSocket &operator=(const UdpSocket &) = delete;
+
+  // port 0 — любой свободный, узнать его можно через getPort()
+  bool open(std::uint16_t port);
+  void close();
+  bool isOpen() const { return handle >= 0; }
+  std::uint16_t getPort() const { return port; }
+
+  void send(const NetAddress &to, const std::uint8_t *data, std::size_t size);
+  // Следующий пришедший пакет; false — очередь пуста
+  bool receive(std::vector<std::uint8_t> &packet, NetAddress &from);
+
+private:
+  int handle;
+  std::uint16_t port;
+};
+
+// Условия канала для проверки на loopback
+struct LinkConditions {
+  float latency = 0.0f; // задержка в одну сторону, секунды
+  float jitter = 0.0f;  // разброс задержки, пакеты обгоняют друг друга
+  float loss = 0.0f;    // доля потерянных пакетов
+};
+
+// Прослойка между протоколом и сокетом, которая изображает плохую сеть:
+// исходящий пакет теряется с вероятностью loss или уходит в сокет не
+// раньше, чем через latency +- jitter. Время передает вызывающий, поэтому
+// тот же код работает и с часами игры, и с виртуальными часами теста.
+class LinkShim {
+public:
+  LinkShim(UdpSocket &socket, const LinkConditions &conditions,
+           RandomStream rng);
+
+  void send(const NetAddress &to, const std::vector<std::uint8_t> &packet,
+            double now);
+  // Отправляет пакеты, задержка которых истекла
+  void flush(double now);
+
+private:
+  struct Pending {
+    double due;
+    NetAddress to;
+    std::vector<std::uint8_t> data;
+  };
+
+  UdpSocket &socket;
+  LinkConditions conditions;
+  RandomStream rng;
+  std::vector<Pending> pending;
+};
@@ -0,0 +1,117 @@
+#include "BatchRenderer.hpp"
+#include "../utils/MathUtils.hpp"
+#include "../utils/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Диск радиуса DISC_RADIUS в центре текстуры со сглаженным краем
+constexpr int DISC_TEXTURE_SIZE = 64;
+constexpr float DISC_RADIUS = 31.0f;
+constexpr float DISC_CENTER = DISC_TEXTURE_SIZE / 2.0f;
+
+// Участок в центре диска, где все тексели непрозрачны, — для прямоугольников
+const sf::Vector2f SOLID_TEX_MIN(DISC_CENTER - 1, DISC_CENTER - 1);
+const sf::Vector2f SOLID_TEX_MAX(DISC_CENTER + 1, DISC_CENTER + 1);
+} // namespace
+
+BatchRenderer::BatchRenderer() : vertices(sf::Triangles) {
+  sf::Image disc;
+  disc.create(DISC_TEXTURE_SIZE, DISC_TEXTURE_SIZE, sf::Color::Transparent);
+  for (int y = 0; y < DISC_TEXTURE_SIZE; y++) {
+    for (int x = 0; x < DISC_TEXTURE_SIZE; x++) {
+      float dx = x + 0.5f - DISC_CENTER;
+      float dy = y + 0.5f - DISC_CENTER;
+      float coverage =
+          std::max(0.0f, std::min(1.0f, DISC_RADIUS + 0.5f -
+                                            std::sqrt(dx * dx + dy * dy)));
+      disc.setPixel(x, y,
+                    sf::Color(255, 255, 255,
+                              static_cast<sf::Uint8>(255 * coverage)));
+    }
+  }
+  discTexture.loadFromImage(disc);
+  discTexture.setSmooth(true);
+}
+
+void BatchRenderer::begin() {
+  lastFrame = currentFrame;
+  currentFrame = FrameStats();
+  vertices.clear(); // емкость массива сохраняется между кадрами
+}
+
+void BatchRenderer::addQuad(sf::Vector2f topLeft, sf::Vector2f bottomRight,
+                            sf::Vector2f texTopLeft,
+                            sf::Vector2f texBottomRight, sf::Color color) {
+  sf::Vertex a(topLeft, color, texTopLeft);
+  sf::Vertex b(sf::Vector2f(bottomRight.x, topLeft.y), color,
+               sf::Vector2f(texBottomRight.x, texTopLeft.y));
+  sf::Vertex c(bottomRight, color, texBottomRight);
+  sf::Vertex d(sf::Vector2f(topLeft.x, bottomRight.y), color,
+               sf::Vector2f(texTopLeft.x, texBottomRight.y));
+  vertices.append(a);
+  vertices.append(b);
+  vertices.append(c);
+  vertices.append(a);
+  vertices.append(c);
+  vertices.append(d);
+}
+
+void BatchRenderer::addCircle(sf::Vector2f center, float radius,
+                              sf::Color fill) {
+  // Квадрат чуть больше круга, чтобы край диска в текстуре совпал с radius
+  float halfExtent = radius * DISC_CENTER / DISC_RADIUS;
+  sf::Vector2f offset(halfExtent, halfExtent);
+  addQuad(center - offset, center + offset, sf::Vector2f(0, 0),
+          sf::Vector2f(DISC_TEXTURE_SIZE, DISC_TEXTURE_SIZE), fill);
+}
+
+void BatchRenderer::addCircle(sf::Vector2f center, float radius,
+                              sf::Color fill, float outlineThickness,
+                              sf::Color outline) {
+  // Обводка — диск побольше под основным. У полупрозрачной заливки
+  // приглушаем и обводку, чтобы она не проступала сквозь круг.
+  if (outlineThickness > 0) {
+    outline.a = static_cast<sf::Uint8>(outline.a * fill.a / 255);
+    addCircle(center, radius + outlineThickness, outline);
+  }
+  addCircle(center, radius, fill);
+}
+
+void BatchRenderer::addRect(sf::Vector2f topLeft, sf::Vector2f size,
+                            sf::Color color) {
+  addQuad(topLeft, topLeft + size, SOLID_TEX_MIN, SOLID_TEX_MAX, color);
+}
+
+void BatchRenderer::addLine(sf::Vector2f from, sf::Vector2f to,
+                            sf::Color fromColor, sf::Color toColor,
+                            float thickness) {
+  sf::Vector2f direction = MathUtils::normalize(to - from);
+  sf::Vector2f normal(-direction.y * thickness / 2,
+                      direction.x * thickness / 2);
+  sf::Vector2f tex = (SOLID_TEX_MIN + SOLID_TEX_MAX) / 2.0f;
+  sf::Vertex a(from + normal, fromColor, tex);
+  sf::Vertex b(to + normal, toColor, tex);
+  sf::Vertex c(to - normal, toColor, tex);
+  sf::Vertex d(from - normal, fromColor, tex);
+  vertices.append(a);
+  vertices.append(b);
+  vertices.append(c);
+  vertices.append(a);
+  vertices.append(c);
+  vertices.append(d);
+}
+
+void BatchRenderer::flush(sf::RenderTarget &target) {
+  if (vertices.getVertexCount() == 0)
+    return;
+  PROFILE_ZONE("render.flush");
+  target.draw(vertices, sf::RenderStates(&discTexture));
+  countDrawCall(static_cast<int>(vertices.getVertexCount()));
+  vertices.clear();
+}
+
+void BatchRenderer::countDrawCall(int vertexCount) {
+  currentFrame.drawCalls++;
+  currentFrame.vertices += vertexCount;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+
+// Собирает круги, прямоугольники и линии кадра в один массив вершин и
+// рисует его одним вызовом. Круги — это квадраты с текстурой диска, поэтому
+// их стоимость не зависит от числа сегментов. Работает на любом GL, где
+// доступен SFML, в том числе на программном (Mesa llvmpipe).
+class BatchRenderer {
+public:
+  struct FrameStats {
+    int drawCalls = 0;
+    int vertices = 0;
+  };
+
+  BatchRenderer();
+
+  void begin();
+  void addCircle(sf::Vector2f center, float radius, sf::Color fill);
+  // Обводка снаружи круга, как у sf::CircleShape
+  void addCircle(sf::Vector2f center, float radius, sf::Color fill,
+                 float outlineThickness, sf::Color outline);
+  void addRect(sf::Vector2f topLeft, sf::Vector2f size, sf::Color color);
+  void addLine(sf::Vector2f from, sf::Vector2f to, sf::Color fromColor,
+               sf::Color toColor, float thickness = 1.0f);
+  void flush(sf::RenderTarget &target);
+
+  // Учет вызовов, нарисованных в обход пакета (например, местность)
+  void countDrawCall(int vertices);
+
+  // Статистика последнего завершенного кадра
+  const FrameStats &getStats() const { return lastFrame; }
+
+private:
+  void addQuad(sf::Vector2f topLeft, sf::Vector2f bottomRight,
+               sf::Vector2f texTopLeft, sf::Vector2f texBottomRight,
+               sf::Color color);
+
+  sf::Texture discTexture;
+  sf::VertexArray vertices;
+  FrameStats currentFrame;
+  FrameStats lastFrame;
+};
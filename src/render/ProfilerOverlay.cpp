@@ -0,0 +1,64 @@
+#include "ProfilerOverlay.hpp"
+#include "../utils/GameTypes.hpp"
+#include "WorldRenderer.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+constexpr float PIXELS_PER_MS = 20.0f;
+constexpr float BUDGET_MS = 1000.0f / 60.0f;
+constexpr float PANEL_WIDTH = 2 * BUDGET_MS * PIXELS_PER_MS;
+constexpr float ROW_HEIGHT = 12.0f;
+
+float barLength(double milliseconds) {
+  return std::min(static_cast<float>(milliseconds) * PIXELS_PER_MS,
+                  PANEL_WIDTH);
+}
+} // namespace
+
+void ProfilerOverlay::draw(BatchRenderer &batch,
+                           const std::vector<Profiler::ZoneSummary> &zones) {
+  if (zones.empty())
+    return;
+  sf::Vector2f origin(GameTypes::WINDOW_WIDTH - PANEL_WIDTH - 30, 10);
+  batch.addRect(origin - sf::Vector2f(4, 4),
+                sf::Vector2f(PANEL_WIDTH + 24, zones.size() * ROW_HEIGHT + 6),
+                sf::Color(0, 0, 0, 160));
+
+  for (std::size_t i = 0; i < zones.size(); i++) {
+    const Profiler::ZoneSummary &zone = zones[i];
+    sf::Vector2f rowPos = origin + sf::Vector2f(0, i * ROW_HEIGHT);
+    // Цвет — метка зоны, тот же порядок, что в заголовке окна
+    sf::Color color = WorldRenderer::teamColor(static_cast<int>(i));
+    batch.addRect(rowPos, sf::Vector2f(8, ROW_HEIGHT - 4), color);
+
+    sf::Vector2f barPos = rowPos + sf::Vector2f(14, 0);
+    sf::Color dim = color;
+    dim.a = 90;
+    batch.addRect(barPos, sf::Vector2f(barLength(zone.p99), ROW_HEIGHT - 4),
+                  dim);
+    batch.addRect(barPos, sf::Vector2f(barLength(zone.p50), ROW_HEIGHT - 4),
+                  color);
+    batch.addRect(barPos + sf::Vector2f(barLength(zone.max), 0),
+                  sf::Vector2f(2, ROW_HEIGHT - 4), sf::Color::Red);
+  }
+
+  float budgetX = origin.x + 14 + BUDGET_MS * PIXELS_PER_MS;
+  batch.addRect(sf::Vector2f(budgetX, origin.y - 2),
+                sf::Vector2f(1, zones.size() * ROW_HEIGHT),
+                sf::Color::White);
+}
+
+std::string
+ProfilerOverlay::describe(const std::vector<Profiler::ZoneSummary> &zones) {
+  // имя медиана/p99/максимум в мс
+  std::string text;
+  char entry[96];
+  for (const Profiler::ZoneSummary &zone : zones) {
+    std::snprintf(entry, sizeof(entry), "%s%s %.2f/%.2f/%.2f",
+                  text.empty() ? "" : ", ", zone.name.c_str(), zone.p50,
+                  zone.p99, zone.max);
+    text += entry;
+  }
+  return text;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "../utils/Profiler.hpp"
+#include "BatchRenderer.hpp"
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// Панель профилировщика в координатах окна: по полосе на зону, в порядке
+// Profiler::summary(). Светлая часть — медиана, тусклая — p99, красная
+// засечка — максимум; белая черта — бюджет кадра в 60 Гц. Шрифтов в игре
+// нет, поэтому цифры идут строкой (describe) в заголовок окна.
+class ProfilerOverlay {
+public:
+  void draw(BatchRenderer &batch,
+            const std::vector<Profiler::ZoneSummary> &zones);
+  static std::string describe(const std::vector<Profiler::ZoneSummary> &zones);
+};
@@ -0,0 +1,171 @@
+#include "TerrainRenderer.hpp"
+#include "../utils/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const sf::Color TERRAIN_COLOR(139, 69, 19);
+constexpr int CHUNK_SIZE = OccupancyGrid::CHUNK_SIZE;
+} // namespace
+
+TerrainRenderer::TerrainRenderer()
+    : chunksX(0), chunksY(0), syncedMapVersion(0), syncedDestructions(0) {}
+
+void TerrainRenderer::sync(const TerrainManager &terrain) {
+  const OccupancyGrid &grid = terrain.getGrid();
+
+  // Новая карта: все текстуры выбрасываем, видимые создадутся заново
+  if (terrain.getMapVersion() != syncedMapVersion) {
+    chunksX = grid.getChunksX();
+    chunksY = grid.getChunksY();
+    chunkTextures.clear();
+    chunkTextures.resize(static_cast<size_t>(chunksX) * chunksY);
+    syncedMapVersion = terrain.getMapVersion();
+    syncedDestructions = terrain.getDestructions().size();
+    return;
+  }
+
+  // Воронка может задеть несколько чанков. Чанки без текстуры пропускаем:
+  // при создании текстура и так заливается целиком.
+  const std::vector<TerrainDestruction> &destructions =
+      terrain.getDestructions();
+  for (; syncedDestructions < destructions.size(); syncedDestructions++) {
+    const TerrainDestruction &d = destructions[syncedDestructions];
+    int left = std::max(d.centerX - d.radius, 0);
+    int top = std::max(d.centerY - d.radius, 0);
+    int right = std::min(d.centerX + d.radius + 1, terrain.getWidth());
+    int bottom = std::min(d.centerY + d.radius + 1, terrain.getHeight());
+    if (left >= right || top >= bottom)
+      continue;
+    for (int cy = top / CHUNK_SIZE; cy <= (bottom - 1) / CHUNK_SIZE; cy++) {
+      for (int cx = left / CHUNK_SIZE; cx <= (right - 1) / CHUNK_SIZE; cx++) {
+        ChunkTexture &chunk = chunkTextures[cy * chunksX + cx];
+        if (!chunk.texture)
+          continue;
+        int originX = cx * CHUNK_SIZE, originY = cy * CHUNK_SIZE;
+        int localLeft = std::max(left, originX) - originX;
+        int localTop = std::max(top, originY) - originY;
+        int localRight = std::min(right, originX + CHUNK_SIZE) - originX;
+        int localBottom = std::min(bottom, originY + CHUNK_SIZE) - originY;
+        markDirty(chunk.dirtyRects,
+                  sf::IntRect(localLeft, localTop, localRight - localLeft,
+                              localBottom - localTop));
+      }
+    }
+  }
+}
+
+void TerrainRenderer::markDirty(std::vector<sf::IntRect> &dirtyRects,
+                                sf::IntRect rect) {
+  // Сливаем с пересекающимися прямоугольниками, пока есть что сливать
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < dirtyRects.size(); i++) {
+      const sf::IntRect &other = dirtyRects[i];
+      if (rect.intersects(other)) {
+        int left = std::min(rect.left, other.left);
+        int top = std::min(rect.top, other.top);
+        int right = std::max(rect.left + rect.width, other.left + other.width);
+        int bottom =
+            std::max(rect.top + rect.height, other.top + other.height);
+        rect = sf::IntRect(left, top, right - left, bottom - top);
+        dirtyRects[i] = dirtyRects.back();
+        dirtyRects.pop_back();
+        merged = true;
+        break;
+      }
+    }
+  }
+  dirtyRects.push_back(rect);
+}
+
+void TerrainRenderer::upload(sf::Texture &texture,
+                             const OccupancyGrid::Chunk &chunk,
+                             const sf::IntRect &rect) {
+  PROFILE_ZONE("terrain.upload");
+  // Пиксели текстуры однозначно задаются битами чанка
+  uploadBuffer.resize(static_cast<size_t>(rect.width) * rect.height * 4);
+  sf::Uint8 *pixel = uploadBuffer.data();
+  for (int y = rect.top; y < rect.top + rect.height; y++) {
+    const OccupancyGrid::Word *row =
+        chunk.words + y * OccupancyGrid::CHUNK_WORDS;
+    for (int x = rect.left; x < rect.left + rect.width; x++) {
+      bool solid = (row[x >> 6] >> (x & 63)) & 1u;
+      const sf::Color &color = solid ? TERRAIN_COLOR : sf::Color::Transparent;
+      pixel[0] = color.r;
+      pixel[1] = color.g;
+      pixel[2] = color.b;
+      pixel[3] = color.a;
+      pixel += 4;
+    }
+  }
+  texture.update(uploadBuffer.data(), rect.width, rect.height, rect.left,
+                 rect.top);
+}
+
+int TerrainRenderer::draw(sf::RenderTarget &target,
+                          const TerrainManager &terrain,
+                          const sf::FloatRect &visible) {
+  sync(terrain);
+  const OccupancyGrid &grid = terrain.getGrid();
+
+  // Диапазон видимых чанков; текстуры держим еще на чанк вокруг, чтобы
+  // камера, качнувшаяся у границы, не пересоздавала их каждый кадр
+  int firstX = std::max(static_cast<int>(std::floor(visible.left)) /
+                            CHUNK_SIZE, 0);
+  int firstY = std::max(static_cast<int>(std::floor(visible.top)) /
+                            CHUNK_SIZE, 0);
+  int lastX = std::min(static_cast<int>(std::ceil(visible.left +
+                                                   visible.width)) /
+                           CHUNK_SIZE,
+                       chunksX - 1);
+  int lastY = std::min(static_cast<int>(std::ceil(visible.top +
+                                                   visible.height)) /
+                           CHUNK_SIZE,
+                       chunksY - 1);
+
+  for (int cy = 0; cy < chunksY; cy++) {
+    for (int cx = 0; cx < chunksX; cx++) {
+      ChunkTexture &chunk = chunkTextures[cy * chunksX + cx];
+      if (chunk.texture && (cx < firstX - 1 || cx > lastX + 1 ||
+                            cy < firstY - 1 || cy > lastY + 1)) {
+        chunk.texture.reset();
+        chunk.dirtyRects.clear();
+      }
+    }
+  }
+
+  int drawCalls = 0;
+  sf::Sprite sprite;
+  for (int cy = firstY; cy <= lastY; cy++) {
+    for (int cx = firstX; cx <= lastX; cx++) {
+      // Пустой чанк не хранится в сетке, рисовать в нем нечего
+      const OccupancyGrid::Chunk *bits = grid.chunkAt(cx, cy);
+      if (!bits)
+        continue;
+
+      ChunkTexture &chunk = chunkTextures[cy * chunksX + cx];
+      if (!chunk.texture) {
+        // Крайние чанки обрезаны по размеру карты
+        int width = std::min(CHUNK_SIZE, terrain.getWidth() - cx * CHUNK_SIZE);
+        int height =
+            std::min(CHUNK_SIZE, terrain.getHeight() - cy * CHUNK_SIZE);
+        chunk.texture.reset(new sf::Texture());
+        chunk.texture->create(width, height);
+        chunk.dirtyRects.clear();
+        upload(*chunk.texture, *bits, sf::IntRect(0, 0, width, height));
+      }
+      for (const sf::IntRect &rect : chunk.dirtyRects)
+        upload(*chunk.texture, *bits, rect);
+      chunk.dirtyRects.clear();
+
+      sprite.setTexture(*chunk.texture, true);
+      sprite.setPosition(static_cast<float>(cx * CHUNK_SIZE),
+                         static_cast<float>(cy * CHUNK_SIZE));
+      target.draw(sprite);
+      drawCalls++;
+    }
+  }
+  return drawCalls;
+}
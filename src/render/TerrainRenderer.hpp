@@ -0,0 +1,42 @@
+#pragma once
+#include "../terrain/TerrainManager.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Текстуры местности по чанкам OccupancyGrid. Текстура чанка создается,
+// только когда чанк попадает в кадр и в нем есть земля, и выбрасывается,
+// когда камера уходит дальше чем на чанк от него. Наблюдает за
+// TerrainManager через номер карты и журнал разрушений и догружает только
+// изменившиеся прямоугольники видимых чанков.
+class TerrainRenderer {
+private:
+  struct ChunkTexture {
+    std::unique_ptr<sf::Texture> texture; // nullptr — не создана
+    // Области текстуры в координатах чанка, изменившиеся с загрузки
+    std::vector<sf::IntRect> dirtyRects;
+  };
+
+  std::vector<ChunkTexture> chunkTextures;
+  int chunksX, chunksY;
+
+  std::uint64_t syncedMapVersion;
+  size_t syncedDestructions;
+
+  std::vector<sf::Uint8> uploadBuffer;
+
+  void sync(const TerrainManager &terrain);
+  static void markDirty(std::vector<sf::IntRect> &dirtyRects,
+                        sf::IntRect rect);
+  void upload(sf::Texture &texture, const OccupancyGrid::Chunk &chunk,
+              const sf::IntRect &rect);
+
+public:
+  TerrainRenderer();
+
+  // Рисует чанки, пересекающие visible (в координатах мира). Возвращает
+  // число вызовов отрисовки.
+  int draw(sf::RenderTarget &target, const TerrainManager &terrain,
+           const sf::FloatRect &visible);
+};
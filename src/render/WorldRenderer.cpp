@@ -0,0 +1,193 @@
+#include "WorldRenderer.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const sf::Color TEAM_PALETTE[] = {
+    sf::Color::Green,        sf::Color::Blue,        sf::Color(220, 20, 60),
+    sf::Color(255, 140, 0),  sf::Color::Magenta,     sf::Color::Cyan,
+    sf::Color::Yellow,       sf::Color(128, 0, 128),
+};
+constexpr int PALETTE_SIZE = sizeof(TEAM_PALETTE) / sizeof(TEAM_PALETTE[0]);
+} // namespace
+
+sf::Color WorldRenderer::teamColor(int teamId) {
+  return TEAM_PALETTE[teamId % PALETTE_SIZE];
+}
+
+void WorldRenderer::draw(sf::RenderWindow &window, BatchRenderer &batch,
+                         const Simulation &simulation, float alpha) {
+  const sf::View &view = window.getView();
+  sf::Vector2f viewSize = view.getSize();
+  sf::Vector2f viewTopLeft = view.getCenter() - viewSize / 2.0f;
+  sf::FloatRect visible(viewTopLeft.x, viewTopLeft.y, viewSize.x, viewSize.y);
+
+  int terrainCalls;
+  {
+    PROFILE_ZONE("render.terrain");
+    terrainCalls =
+        terrainRenderer.draw(window, simulation.getTerrain(), visible);
+  }
+  for (int i = 0; i < terrainCalls; i++)
+    batch.countDrawCall(4);
+
+  // Червяк с обводкой и полоской здоровья целиком укладывается в этот запас
+  sf::FloatRect wormArea(visible.left - 2 * GameTypes::WORM_RADIUS,
+                         visible.top - 3 * GameTypes::WORM_RADIUS,
+                         visible.width + 4 * GameTypes::WORM_RADIUS,
+                         visible.height + 5 * GameTypes::WORM_RADIUS);
+  teamHealth.assign(simulation.getBattle().teams, 0);
+  for (const auto &worm : simulation.getWorms()) {
+    teamHealth[worm.teamId] += worm.health;
+    if (wormArea.contains(worm.position))
+      drawWorm(batch, worm, alpha);
+  }
+
+  // Снаряд рисуем, если в кадре он сам или любой конец его следа
+  const ProjectilePool &projectiles = simulation.getProjectiles();
+  const TrailArena &trails = projectiles.trails;
+  const float margin = 16.0f;
+  sf::FloatRect projectileArea(visible.left - margin, visible.top - margin,
+                               visible.width + 2 * margin,
+                               visible.height + 2 * margin);
+  for (std::uint32_t slot : projectiles.getLiveSlots()) {
+    int trailSize = trails.size(slot);
+    if (projectileArea.contains(projectiles.positions[slot]) ||
+        (trailSize > 0 &&
+         (projectileArea.contains(trails.at(slot, 0)) ||
+          projectileArea.contains(trails.at(slot, trailSize - 1)))))
+      drawProjectile(batch, projectiles, slot, alpha);
+  }
+}
+
+void WorldRenderer::drawHud(BatchRenderer &batch,
+                            const Simulation &simulation) {
+  // По строке на команду: цвет, общее здоровье и число живых червяков
+  const BattleConfig &battle = simulation.getBattle();
+  int activeTeam = simulation.getActiveWorm().teamId;
+  float maxHealth = 100.0f * battle.wormsPerTeam;
+  for (int team = 0; team < battle.teams; team++) {
+    sf::Vector2f rowPos(10, 10 + team * 14.0f);
+    if (team == activeTeam && !simulation.isGameOver()) {
+      batch.addRect(rowPos - sf::Vector2f(2, 2), sf::Vector2f(14, 14),
+                    sf::Color::White);
+    }
+    batch.addRect(rowPos, sf::Vector2f(10, 10), teamColor(team));
+
+    sf::Vector2f barPos = rowPos + sf::Vector2f(16, 3);
+    batch.addRect(barPos, sf::Vector2f(100, 4), sf::Color(0, 0, 0, 120));
+    batch.addRect(barPos,
+                  sf::Vector2f(100 * teamHealth[team] / maxHealth, 4),
+                  teamColor(team));
+
+    // Живые червяки — короткие засечки под полоской
+    int alive = simulation.getTeamAliveWorms(team);
+    float tickWidth = std::min(4.0f, 100.0f / battle.wormsPerTeam);
+    for (int i = 0; i < alive; i++) {
+      batch.addRect(barPos + sf::Vector2f(i * tickWidth, 5),
+                    sf::Vector2f(std::max(1.0f, tickWidth - 1), 2),
+                    sf::Color::White);
+    }
+  }
+}
+
+void WorldRenderer::drawWorm(BatchRenderer &batch, const Worm &worm,
+                             float alpha) {
+  // Рисуем между двумя последними состояниями симуляции
+  sf::Vector2f drawPos =
+      worm.previousPosition + (worm.position - worm.previousPosition) * alpha;
+
+  sf::Color color = teamColor(worm.teamId);
+  float outlineThickness = 2;
+  sf::Color outlineColor = sf::Color::Black;
+  if (!worm.isActive) {
+    color.a = 100;
+  } else if (worm.isMyTurn) {
+    // Подсвечиваем активного игрока
+    outlineThickness = 4;
+    outlineColor = sf::Color::White;
+  }
+  batch.addCircle(drawPos, GameTypes::WORM_RADIUS, color, outlineThickness,
+                  outlineColor);
+
+  if (worm.isActive) {
+    // Рисуем полоску здоровья
+    sf::Vector2f barPos(drawPos.x - 15, drawPos.y - 25);
+    float healthPercent = static_cast<float>(worm.health) / worm.maxHealth;
+
+    sf::Color barColor;
+    if (healthPercent > 0.6f) {
+      barColor = sf::Color::Green;
+    } else if (healthPercent > 0.3f) {
+      barColor = sf::Color::Yellow;
+    } else {
+      barColor = sf::Color::Red;
+    }
+
+    batch.addRect(barPos, sf::Vector2f(30, 4), sf::Color::Red);
+    batch.addRect(barPos, sf::Vector2f(30 * healthPercent, 4), barColor);
+  }
+}
+
+void WorldRenderer::drawProjectile(BatchRenderer &batch,
+                                   const ProjectilePool &projectiles,
+                                   std::uint32_t slot, float alpha) {
+  if (!projectiles.activeFlags[slot])
+    return;
+
+  sf::Vector2f previous = projectiles.previousPositions[slot];
+  sf::Vector2f drawPos =
+      previous + (projectiles.positions[slot] - previous) * alpha;
+  bool isLaunching = projectiles.launchingFlags[slot];
+
+  // Внешний вид зависит от типа оружия
+  float radius;
+  sf::Color fillColor;
+  sf::Color trailColor;
+  switch (projectiles.weaponTypes[slot]) {
+  case GameTypes::WeaponType::SNIPER_RIFLE:
+    radius = 2;
+    fillColor = sf::Color::Blue;
+    trailColor = sf::Color::Blue;
+    break;
+  case GameTypes::WeaponType::FRAG_GRENADE:
+    radius = 6;
+    fillColor = sf::Color::Green;
+    trailColor = sf::Color::Green;
+    break;
+  default: // BAZOOKA
+    radius = GameTypes::PROJECTILE_RADIUS;
+    fillColor = sf::Color::Yellow;
+    trailColor = sf::Color::Yellow;
+    break;
+  }
+  if (projectiles.shrapnelFlags[slot]) {
+    radius = 2;
+    fillColor = sf::Color::Red;
+  }
+
+  // Рисуем след снаряда
+  const TrailArena &trails = projectiles.trails;
+  int trailSize = trails.size(slot);
+  if (!isLaunching && trailSize > 1) {
+    for (int i = 1; i < trailSize; i++) {
+      // Яркость и размер убывают вдоль следа при любой его длине
+      float fade = 1.0f - static_cast<float>(i) / trailSize;
+      sf::Color pointColor = trailColor;
+      pointColor.a = static_cast<sf::Uint8>(255 * fade);
+      batch.addCircle(trails.at(slot, i), 1.5f * fade, pointColor);
+    }
+  }
+
+  // Рисуем основной снаряд
+  if (isLaunching) {
+    float scale = 1.0f + 0.8f * sin(projectiles.totalTimes[slot] * 30);
+    fillColor = sf::Color::White;
+    fillColor.a =
+        static_cast<sf::Uint8>(255 * (projectiles.launchTimers[slot] / 0.2f));
+    radius *= scale;
+  }
+  batch.addCircle(drawPos, radius, fillColor, 1, sf::Color::Red);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "../entities/ProjectilePool.hpp"
+#include "../entities/Worm.hpp"
+#include "../game/Simulation.hpp"
+#include "BatchRenderer.hpp"
+#include "TerrainRenderer.hpp"
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// Рисует состояние симуляции в текущем виде (камере) окна. Местность идет
+// отдельными спрайтами по чанкам, а червяки, снаряды и следы складываются в
+// общий пакет BatchRenderer. Все, что не попадает в кадр, пропускается.
+class WorldRenderer {
+private:
+  TerrainRenderer terrainRenderer;
+  std::vector<int> teamHealth; // собирается при отрисовке червяков
+
+  void drawWorm(BatchRenderer &batch, const Worm &worm, float alpha);
+  void drawProjectile(BatchRenderer &batch, const ProjectilePool &projectiles,
+                      std::uint32_t slot, float alpha);
+
+public:
+  void draw(sf::RenderWindow &window, BatchRenderer &batch,
+            const Simulation &simulation, float alpha);
+  // Панель команд в координатах окна; рисовать после draw() без камеры
+  void drawHud(BatchRenderer &batch, const Simulation &simulation);
+
+  // Цвета команд повторяются по кругу, если команд больше палитры
+  static sf::Color teamColor(int teamId);
+};
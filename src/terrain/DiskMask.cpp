@@ -0,0 +1,39 @@
+#include "DiskMask.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+
+DiskMask::DiskMask(int r) : radius(r), halfWidths(r + 1) {
+  // Целочисленный обход границы круга без sqrt
+  int dx = r;
+  for (int dy = 0; dy <= r; dy++) {
+    while (dx * dx + dy * dy > r * r)
+      dx--;
+    halfWidths[dy] = static_cast<std::int16_t>(dx);
+  }
+}
+
+const DiskMask &DiskMask::forRadius(int radius) {
+  if (radius < 0)
+    radius = 0;
+
+  if (radius <= MAX_CACHED_RADIUS) {
+    static const std::vector<DiskMask> cache = [] {
+      std::vector<DiskMask> masks;
+      masks.reserve(MAX_CACHED_RADIUS + 1);
+      for (int r = 0; r <= MAX_CACHED_RADIUS; r++)
+        masks.push_back(DiskMask(r));
+      return masks;
+    }();
+    return cache[radius];
+  }
+
+  // Редкие большие радиусы кешируем отдельно
+  static std::mutex largeMutex;
+  static std::map<int, std::unique_ptr<DiskMask>> large;
+  std::lock_guard<std::mutex> lock(largeMutex);
+  std::unique_ptr<DiskMask> &mask = large[radius];
+  if (!mask)
+    mask.reset(new DiskMask(radius));
+  return *mask;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Таблица строк круга радиуса r: halfWidth(dy) — наибольший dx, для которого
+// dx*dx + dy*dy <= r*r. Круг симметричен, поэтому хранятся только dy >= 0.
+class DiskMask {
+public:
+  static constexpr int MAX_CACHED_RADIUS = 64;
+
+  // Таблицы строятся при первом обращении и живут до конца программы
+  static const DiskMask &forRadius(int radius);
+
+  int getRadius() const { return radius; }
+  int halfWidth(int dy) const { return halfWidths[dy < 0 ? -dy : dy]; }
+
+private:
+  explicit DiskMask(int r);
+
+  int radius;
+  std::vector<std::int16_t> halfWidths;
+};
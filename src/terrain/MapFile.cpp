@@ -0,0 +1,265 @@
+#include "MapFile.hpp"
+#include "../utils/BinaryIO.hpp"
+#include "SurfaceIndex.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+using Word = OccupancyGrid::Word;
+using Chunk = OccupancyGrid::Chunk;
+
+constexpr char MAGIC[4] = {'W', 'M', 'A', 'P'};
+constexpr std::size_t HEADER_SIZE = 24;
+constexpr std::size_t TABLE_ENTRY_SIZE = 16;
+constexpr int CHUNK_WORD_COUNT = OccupancyGrid::CHUNK_SIZE *
+                                 OccupancyGrid::CHUNK_WORDS;
+constexpr int CHUNK_BITS = CHUNK_WORD_COUNT * OccupancyGrid::WORD_BITS;
+constexpr std::size_t RAW_CHUNK_BYTES = CHUNK_WORD_COUNT * sizeof(Word);
+constexpr int MAX_HEIGHT = SurfaceIndex::MAX_HEIGHT;
+constexpr int MAX_WIDTH = SurfaceIndex::MAX_WIDTH;
+
+// Первый бит с номером >= from, не равный value, или CHUNK_BITS
+int nextChange(const Word *words, int from, bool value) {
+  Word flip = value ? ~Word(0) : 0;
+  int i = from >> 6;
+  Word diff = (words[i] ^ flip) & (~Word(0) << (from & 63));
+  while (!diff) {
+    if (++i == CHUNK_WORD_COUNT)
+      return CHUNK_BITS;
+    diff = words[i] ^ flip;
+  }
+  return i * OccupancyGrid::WORD_BITS + __builtin_ctzll(diff);
+}
+
+// Биты [from, to) чанка, строки которого идут подряд
+void fillBits(Word *words, int from, int to) {
+  if (from >= to)
+    return;
+  int w0 = from >> 6, w1 = (to - 1) >> 6;
+  Word first = ~Word(0) << (from & 63);
+  Word last = ~Word(0) >> (63 - ((to - 1) & 63));
+  if (w0 == w1) {
+    words[w0] |= first & last;
+    return;
+  }
+  words[w0] |= first;
+  for (int i = w0 + 1; i < w1; i++)
+    words[i] = ~Word(0);
+  words[w1] |= last;
+}
+
+// Биты за краем карты в крайних чанках должны быть пустыми
+void clearOutside(Chunk &chunk, int localWidth, int localHeight) {
+  for (int y = 0; y < OccupancyGrid::CHUNK_SIZE; y++) {
+    Word *row = chunk.words + y * OccupancyGrid::CHUNK_WORDS;
+    for (int i = 0; i < OccupancyGrid::CHUNK_WORDS; i++) {
+      int first = i * OccupancyGrid::WORD_BITS;
+      if (y >= localHeight || first >= localWidth)
+        row[i] = 0;
+      else if (localWidth - first < OccupancyGrid::WORD_BITS)
+        row[i] &= ~(~Word(0) << (localWidth - first));
+    }
+  }
+}
+
+const std::shared_ptr<Chunk> &fullChunk() {
+  static const std::shared_ptr<Chunk> chunk = [] {
+    auto full = std::make_shared<Chunk>();
+    std::fill(std::begin(full->words), std::end(full->words), ~Word(0));
+    return full;
+  }();
+  return chunk;
+}
+} // namespace
+
+MapFile::MapFile()
+    : data(nullptr), size(0), width(0), height(0), chunksX(0), chunksY(0) {}
+
+MapFile::~MapFile() { close(); }
+
+void MapFile::close() {
+  if (data)
+    munmap(const_cast<std::uint8_t *>(data), size);
+  path.clear();
+  data = nullptr;
+  size = 0;
+  width = height = chunksX = chunksY = 0;
+}
+
+bool MapFile::save(const std::string &path, const OccupancyGrid &grid) {
+  int count = grid.getChunksX() * grid.getChunksY();
+  ByteWriter header;
+  header.bytes(MAGIC, 4);
+  header.u32(VERSION);
+  header.u32(grid.getWidth());
+  header.u32(grid.getHeight());
+  header.u32(OccupancyGrid::CHUNK_SIZE);
+  header.u32(count);
+
+  ByteWriter payload, runs;
+  std::uint64_t payloadStart = HEADER_SIZE + TABLE_ENTRY_SIZE * count;
+  for (int cy = 0; cy < grid.getChunksY(); cy++) {
+    for (int cx = 0; cx < grid.getChunksX(); cx++) {
+      const Chunk *chunk = grid.chunkAt(cx, cy);
+      Encoding encoding = EMPTY;
+      std::uint64_t offset = payloadStart + payload.size();
+      if (chunk && nextChange(chunk->words, 0, true) == CHUNK_BITS) {
+        encoding = FULL;
+      } else if (chunk && nextChange(chunk->words, 0, false) < CHUNK_BITS) {
+        // Серии чередуются, первая — пустая (может быть нулевой)
+        runs.clear();
+        bool value = false;
+        int pos = 0;
+        while (pos < CHUNK_BITS) {
+          int next = nextChange(chunk->words, pos, value);
+          runs.varint(next - pos);
+          pos = next;
+          value = !value;
+        }
+
+        if (runs.size() < RAW_CHUNK_BYTES) {
+          encoding = RUNS;
+          payload.bytes(runs.data().data(), runs.size());
+        } else {
+          encoding = BITS;
+          for (Word word : chunk->words)
+            payload.u64(word);
+        }
+      }
+      header.u8(encoding);
+      header.u8(0);
+      header.u8(0);
+      header.u8(0);
+      header.u32(static_cast<std::uint32_t>(payloadStart + payload.size() -
+                                            offset));
+      header.u64(offset);
+    }
+  }
+
+  FILE *file = std::fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+  bool ok = std::fwrite(header.data().data(), 1, header.size(), file) ==
+                header.size() &&
+            std::fwrite(payload.data().data(), 1, payload.size(), file) ==
+                payload.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+bool MapFile::open(const std::string &filePath) {
+  close();
+  int fd = ::open(filePath.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<std::size_t>(info.st_size) < HEADER_SIZE) {
+    ::close(fd);
+    return false;
+  }
+  size = static_cast<std::size_t>(info.st_size);
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    size = 0;
+    return false;
+  }
+  data = static_cast<const std::uint8_t *>(mapped);
+
+  ByteReader reader(data, size);
+  char magic[4];
+  reader.bytes(magic, 4);
+  std::uint32_t version = reader.u32();
+  std::uint32_t fileWidth = reader.u32();
+  std::uint32_t fileHeight = reader.u32();
+  std::uint32_t chunkSize = reader.u32();
+  std::uint32_t count = reader.u32();
+  bool valid = std::memcmp(magic, MAGIC, 4) == 0 && version == VERSION &&
+               fileWidth > 0 && fileWidth <= MAX_WIDTH && fileHeight > 0 &&
+               fileHeight <= MAX_HEIGHT &&
+               chunkSize == OccupancyGrid::CHUNK_SIZE;
+  if (valid) {
+    width = static_cast<int>(fileWidth);
+    height = static_cast<int>(fileHeight);
+    chunksX = (width + chunkSize - 1) / chunkSize;
+    chunksY = (height + chunkSize - 1) / chunkSize;
+    valid = count == static_cast<std::uint32_t>(chunksX * chunksY);
+
+    // Ссылки таблицы не должны выходить за файл
+    for (std::uint32_t i = 0; valid && i < count; i++) {
+      std::uint8_t encoding = reader.u8();
+      reader.u8();
+      reader.u8();
+      reader.u8();
+      std::uint64_t length = reader.u32();
+      std::uint64_t offset = reader.u64();
+      if (encoding == RUNS || encoding == BITS)
+        valid = offset <= size && length <= size - offset &&
+                (encoding == RUNS || length == RAW_CHUNK_BYTES);
+      else
+        valid = encoding == EMPTY || encoding == FULL;
+    }
+    valid = valid && reader.ok();
+  }
+  if (valid)
+    path = filePath;
+  else
+    close();
+  return valid;
+}
+
+std::shared_ptr<Chunk> MapFile::decodeChunk(int chunkX, int chunkY) const {
+  std::size_t index = static_cast<std::size_t>(chunkY) * chunksX + chunkX;
+  ByteReader entry(data + HEADER_SIZE + TABLE_ENTRY_SIZE * index,
+                   TABLE_ENTRY_SIZE);
+  std::uint8_t encoding = entry.u8();
+  entry.u8();
+  entry.u8();
+  entry.u8();
+  std::uint32_t length = entry.u32();
+  ByteReader bytes(data + entry.u64(), length);
+
+  int localWidth = std::min(OccupancyGrid::CHUNK_SIZE,
+                            width - chunkX * OccupancyGrid::CHUNK_SIZE);
+  int localHeight = std::min(OccupancyGrid::CHUNK_SIZE,
+                             height - chunkY * OccupancyGrid::CHUNK_SIZE);
+  bool interior = localWidth == OccupancyGrid::CHUNK_SIZE &&
+                  localHeight == OccupancyGrid::CHUNK_SIZE;
+  if (encoding == EMPTY)
+    return nullptr;
+  if (encoding == FULL && interior)
+    return fullChunk();
+
+  auto chunk = std::make_shared<Chunk>();
+  if (encoding == FULL) {
+    std::fill(std::begin(chunk->words), std::end(chunk->words), ~Word(0));
+  } else if (encoding == BITS) {
+    for (Word &word : chunk->words)
+      word = bytes.u64();
+  } else {
+    std::fill(std::begin(chunk->words), std::end(chunk->words), 0);
+    bool value = false;
+    int pos = 0;
+    while (pos < CHUNK_BITS && !bytes.atEnd()) {
+      std::uint64_t run = bytes.varint();
+      if (!bytes.ok())
+        break;
+      int next = static_cast<int>(
+          std::min<std::uint64_t>(run, CHUNK_BITS - pos) + pos);
+      if (value)
+        fillBits(chunk->words, pos, next);
+      pos = next;
+      value = !value;
+    }
+  }
+
+  if (!interior)
+    clearOutside(*chunk, localWidth, localHeight);
+  return chunk;
+}
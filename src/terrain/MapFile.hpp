@@ -0,0 +1,61 @@
+#pragma once
+#include "OccupancyGrid.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Карта на диске (.wmap). Все числа little-endian:
+//
+//   заголовок  "WMAP", версия, ширина, высота, размер чанка,
+//              число чанков (u32 каждое)
+//   таблица    на чанк: кодировка (u8), 3 байта выравнивания, длина (u32),
+//              смещение от начала файла (u64)
+//   данные     закодированные чанки подряд
+//
+// Чанк хранится как 65536 бит строка за строкой. Пустой и сплошной чанки
+// занимают только строку таблицы, чанк с краем поверхности — чередующиеся
+// длины серий пустых и твердых битов (LEB128), а если так выходит длиннее,
+// то сырые биты.
+//
+// Файл открывается через mmap и раскодируется по чанкам прямо из
+// отображения: страницы пустых и сплошных чанков не читаются вовсе.
+class MapFile {
+public:
+  static constexpr std::uint32_t VERSION = 1;
+
+  MapFile();
+  ~MapFile();
+  MapFile(const MapFile &) = delete;
+  MapFile &operator=(const MapFile &) = delete;
+
+  // false — не удалось записать файл
+  static bool save(const std::string &path, const OccupancyGrid &grid);
+
+  // Отображает файл и проверяет заголовок и таблицу чанков. Испорченные
+  // данные чанка не выводят запись за его пределы.
+  bool open(const std::string &path);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  int getChunksX() const { return chunksX; }
+  int getChunksY() const { return chunksY; }
+  // Путь, с которым файл открыт (на него ссылаются записи матчей)
+  const std::string &getPath() const { return path; }
+
+  // Чанк в том виде, в каком его хранит OccupancyGrid: nullptr — пустой.
+  // Сплошные чанки делят один общий экземпляр (запись в сетку его копирует).
+  std::shared_ptr<OccupancyGrid::Chunk> decodeChunk(int chunkX,
+                                                    int chunkY) const;
+
+private:
+  enum Encoding : std::uint8_t { EMPTY = 0, FULL = 1, RUNS = 2, BITS = 3 };
+
+  void close();
+
+  std::string path;
+  const std::uint8_t *data;
+  std::size_t size;
+  int width, height;
+  int chunksX, chunksY;
+};
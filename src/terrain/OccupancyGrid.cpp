@@ -0,0 +1,122 @@
+#include "OccupancyGrid.hpp"
+#include <algorithm>
+
+namespace {
+using Word = OccupancyGrid::Word;
+
+// Маска битов [from, to] внутри одного слова
+inline Word spanMask(int from, int to) {
+  return (~Word(0) << from) & (~Word(0) >> (63 - to));
+}
+
+inline void fillRow(Word *r, int x0, int x1) {
+  int w0 = x0 >> 6, w1 = x1 >> 6;
+  if (w0 == w1) {
+    r[w0] |= spanMask(x0 & 63, x1 & 63);
+    return;
+  }
+  r[w0] |= spanMask(x0 & 63, 63);
+  for (int i = w0 + 1; i < w1; i++)
+    r[i] = ~Word(0);
+  r[w1] |= spanMask(0, x1 & 63);
+}
+
+inline void clearRow(Word *r, int x0, int x1) {
+  int w0 = x0 >> 6, w1 = x1 >> 6;
+  if (w0 == w1) {
+    r[w0] &= ~spanMask(x0 & 63, x1 & 63);
+    return;
+  }
+  r[w0] &= ~spanMask(x0 & 63, 63);
+  for (int i = w0 + 1; i < w1; i++)
+    r[i] = 0;
+  r[w1] &= ~spanMask(0, x1 & 63);
+}
+
+inline bool anyInRow(const Word *r, int x0, int x1) {
+  int w0 = x0 >> 6, w1 = x1 >> 6;
+  if (w0 == w1)
+    return (r[w0] & spanMask(x0 & 63, x1 & 63)) != 0;
+  if (r[w0] & spanMask(x0 & 63, 63))
+    return true;
+  // Средние слова сворачиваем через OR: цикл без ветвлений компилятор
+  // векторизует при -O2
+  Word acc = 0;
+  for (int i = w0 + 1; i < w1; i++)
+    acc |= r[i];
+  return acc != 0 || (r[w1] & spanMask(0, x1 & 63)) != 0;
+}
+} // namespace
+
+OccupancyGrid::OccupancyGrid(int w, int h)
+    : width(w), height(h),
+      chunksX((w + CHUNK_SIZE - 1) / CHUNK_SIZE),
+      chunksY((h + CHUNK_SIZE - 1) / CHUNK_SIZE),
+      chunks(static_cast<std::size_t>(chunksX) * chunksY) {}
+
+OccupancyGrid::Chunk &OccupancyGrid::mutableChunk(int chunkX, int chunkY) {
+  std::shared_ptr<Chunk> &chunk = chunks[chunkY * chunksX + chunkX];
+  if (!chunk) {
+    chunk = std::make_shared<Chunk>();
+    std::fill(std::begin(chunk->words), std::end(chunk->words), 0);
+  } else if (chunk.use_count() > 1) {
+    chunk = std::make_shared<Chunk>(*chunk);
+  }
+  return *chunk;
+}
+
+// Отрезок строки может пересекать несколько чанков: обходим их по очереди
+void OccupancyGrid::fillSpan(int y, int x0, int x1) {
+  int chunkY = y >> CHUNK_SHIFT;
+  int row = (y & CHUNK_MASK) * CHUNK_WORDS;
+  for (int cx = x0 >> CHUNK_SHIFT; cx <= x1 >> CHUNK_SHIFT; cx++) {
+    int base = cx << CHUNK_SHIFT;
+    int from = std::max(x0, base) - base;
+    int to = std::min(x1, base + CHUNK_MASK) - base;
+    fillRow(mutableChunk(cx, chunkY).words + row, from, to);
+  }
+}
+
+void OccupancyGrid::clearSpan(int y, int x0, int x1) {
+  int chunkY = y >> CHUNK_SHIFT;
+  int row = (y & CHUNK_MASK) * CHUNK_WORDS;
+  for (int cx = x0 >> CHUNK_SHIFT; cx <= x1 >> CHUNK_SHIFT; cx++) {
+    // В пустом чанке стирать нечего
+    const std::shared_ptr<Chunk> &chunk = chunks[chunkY * chunksX + cx];
+    if (!chunk)
+      continue;
+    int base = cx << CHUNK_SHIFT;
+    int from = std::max(x0, base) - base;
+    int to = std::min(x1, base + CHUNK_MASK) - base;
+    // Разделенный чанк копируется, только если в отрезке что-то есть
+    if (chunk.use_count() > 1 && !anyInRow(chunk->words + row, from, to))
+      continue;
+    clearRow(mutableChunk(cx, chunkY).words + row, from, to);
+  }
+}
+
+bool OccupancyGrid::anyInSpan(int y, int x0, int x1) const {
+  int chunkY = y >> CHUNK_SHIFT;
+  int row = (y & CHUNK_MASK) * CHUNK_WORDS;
+  // Короткие отрезки (круг червяка) почти всегда лежат в одном чанке
+  if ((x0 >> CHUNK_SHIFT) == (x1 >> CHUNK_SHIFT)) {
+    const Chunk *chunk = chunkAt(x0 >> CHUNK_SHIFT, chunkY);
+    return chunk &&
+           anyInRow(chunk->words + row, x0 & CHUNK_MASK, x1 & CHUNK_MASK);
+  }
+  for (int cx = x0 >> CHUNK_SHIFT; cx <= x1 >> CHUNK_SHIFT; cx++) {
+    const Chunk *chunk = chunkAt(cx, chunkY);
+    if (!chunk)
+      continue;
+    int base = cx << CHUNK_SHIFT;
+    int from = std::max(x0, base) - base;
+    int to = std::min(x1, base + CHUNK_MASK) - base;
+    if (anyInRow(chunk->words + row, from, to))
+      return true;
+  }
+  return false;
+}
+
+void OccupancyGrid::clear() {
+  std::fill(chunks.begin(), chunks.end(), nullptr);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Битовая карта занятости местности, разбитая на квадратные чанки
+// CHUNK_SIZE x CHUNK_SIZE. Чанк — непрерывный буфер 64-битных слов, строки
+// идут подряд по CHUNK_WORDS слов (32 байта). Пустой чанк не хранится.
+// Чанки держатся через shared_ptr: копия сетки разделяет их с оригиналом,
+// а запись в разделенный чанк сначала делает себе копию (copy-on-write).
+class OccupancyGrid {
+public:
+  using Word = std::uint64_t;
+  static constexpr int WORD_BITS = 64;
+  static constexpr int CHUNK_SHIFT = 8;
+  static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+  static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+  static constexpr int CHUNK_WORDS = CHUNK_SIZE / WORD_BITS;
+
+  struct Chunk {
+    Word words[CHUNK_SIZE * CHUNK_WORDS];
+  };
+
+  OccupancyGrid(int w, int h);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  int getChunksX() const { return chunksX; }
+  int getChunksY() const { return chunksY; }
+
+  // Координаты должны лежать внутри сетки
+  bool test(int x, int y) const {
+    const Chunk *chunk =
+        chunks[(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)].get();
+    if (!chunk)
+      return false;
+    int local = x & CHUNK_MASK;
+    return (chunk->words[(y & CHUNK_MASK) * CHUNK_WORDS + (local >> 6)] >>
+            (local & 63)) &
+           1u;
+  }
+
+  // Отрезки [x0, x1] включительно, уже обрезанные по ширине сетки
+  void fillSpan(int y, int x0, int x1);
+  void clearSpan(int y, int x0, int x1);
+  bool anyInSpan(int y, int x0, int x1) const;
+
+  void clear();
+
+  // nullptr — чанк пуст
+  const Chunk *chunkAt(int chunkX, int chunkY) const {
+    return chunks[chunkY * chunksX + chunkX].get();
+  }
+  // Подставляет готовый чанк (загрузка карты). Чанк может быть общим с
+  // другими сетками: перед записью он будет скопирован.
+  void setChunk(int chunkX, int chunkY, std::shared_ptr<Chunk> chunk) {
+    chunks[chunkY * chunksX + chunkX] = std::move(chunk);
+  }
+
+private:
+  // Создает пустой чанк или отделяет разделенный перед записью
+  Chunk &mutableChunk(int chunkX, int chunkY);
+
+  int width, height;
+  int chunksX, chunksY;
+  std::vector<std::shared_ptr<Chunk>> chunks;
+};
@@ -0,0 +1,132 @@
+#include "SurfaceIndex.hpp"
+#include <algorithm>
+
+SurfaceIndex::SurfaceIndex(int w, int h)
+    : width(w), height(h), blocks((w + BLOCK_COLUMNS - 1) / BLOCK_COLUMNS) {
+  for (auto &block : blocks)
+    block = std::make_shared<Block>();
+}
+
+std::vector<SurfaceIndex::Span> &SurfaceIndex::mutableColumn(int x) {
+  std::shared_ptr<Block> &block = blocks[x >> BLOCK_SHIFT];
+  if (block.use_count() > 1)
+    block = std::make_shared<Block>(*block);
+  return block->columns[x & BLOCK_MASK];
+}
+
+void SurfaceIndex::rebuild(const OccupancyGrid &grid) {
+  using Word = OccupancyGrid::Word;
+  constexpr int CHUNK_WORDS = OccupancyGrid::CHUNK_WORDS;
+  // Разделенные блоки не копируем, а заменяем пустыми
+  for (auto &block : blocks) {
+    if (block.use_count() > 1) {
+      block = std::make_shared<Block>();
+    } else {
+      for (auto &column : block->columns)
+        column.clear();
+    }
+  }
+
+  // Каждую строку сравниваем с предыдущей: отрезок столбца открывается
+  // там, где бит появился, и закрывается, где пропал. Чанки обходим
+  // целиком, сверху вниз по каждому столбцу чанков, поэтому строки идут
+  // подряд в памяти, а пустой чанк стоит одного сравнения.
+  std::vector<std::int16_t> openTop(width, 0);
+  auto emitChanges = [&](const Word *row, const Word *above, int x0, int y) {
+    for (int i = 0; i < CHUNK_WORDS; i++) {
+      Word changed = row[i] ^ above[i];
+      while (changed) {
+        int bit = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        int x = x0 + i * OccupancyGrid::WORD_BITS + bit;
+        if ((row[i] >> bit) & 1u)
+          openTop[x] = static_cast<std::int16_t>(y);
+        else
+          blocks[x >> BLOCK_SHIFT]->columns[x & BLOCK_MASK].push_back(
+              {openTop[x], static_cast<std::int16_t>(y - 1)});
+      }
+    }
+  };
+
+  // Последняя строка предыдущей полосы чанков по каждому столбцу чанков
+  const Word zeros[CHUNK_WORDS] = {};
+  std::vector<Word> previous(grid.getChunksX() * CHUNK_WORDS, 0);
+  for (int cy = 0; cy < grid.getChunksY(); cy++) {
+    int y0 = cy * OccupancyGrid::CHUNK_SIZE;
+    int rows = std::min(OccupancyGrid::CHUNK_SIZE, height - y0);
+    for (int cx = 0; cx < grid.getChunksX(); cx++) {
+      const OccupancyGrid::Chunk *chunk = grid.chunkAt(cx, cy);
+      Word *last = previous.data() + cx * CHUNK_WORDS;
+      int x0 = cx * OccupancyGrid::CHUNK_SIZE;
+      if (!chunk) {
+        emitChanges(zeros, last, x0, y0);
+        std::fill(last, last + CHUNK_WORDS, 0);
+        continue;
+      }
+      const Word *above = last;
+      for (int r = 0; r < rows; r++) {
+        const Word *row = chunk->words + r * CHUNK_WORDS;
+        emitChanges(row, above, x0, y0 + r);
+        above = row;
+      }
+      std::copy(above, above + CHUNK_WORDS, last);
+    }
+  }
+
+  // За нижним краем все пусто: закрываем открытые отрезки
+  for (int cx = 0; cx < grid.getChunksX(); cx++)
+    emitChanges(zeros, previous.data() + cx * CHUNK_WORDS,
+                cx * OccupancyGrid::CHUNK_SIZE, height);
+}
+
+void SurfaceIndex::removeSpan(int x, int y0, int y1) {
+  // Столбец, который отрезок не задевает, не отделяется от копий
+  const std::vector<Span> &current = spansAt(x);
+  if (std::none_of(current.begin(), current.end(), [&](const Span &s) {
+        return s.bottom >= y0 && s.top <= y1;
+      }))
+    return;
+  std::vector<Span> &column = mutableColumn(x);
+  for (size_t i = 0; i < column.size(); i++) {
+    Span span = column[i];
+    if (span.bottom < y0)
+      continue;
+    if (span.top > y1)
+      break;
+
+    bool keepTop = span.top < y0;
+    bool keepBottom = span.bottom > y1;
+    if (keepTop && keepBottom) {
+      // Дыра посередине: отрезок распадается на два
+      column[i].bottom = static_cast<std::int16_t>(y0 - 1);
+      column.insert(column.begin() + i + 1,
+                    {static_cast<std::int16_t>(y1 + 1), span.bottom});
+      return;
+    }
+    if (keepTop) {
+      column[i].bottom = static_cast<std::int16_t>(y0 - 1);
+    } else if (keepBottom) {
+      column[i].top = static_cast<std::int16_t>(y1 + 1);
+    } else {
+      column.erase(column.begin() + i);
+      i--;
+    }
+  }
+}
+
+void SurfaceIndex::addSpan(int x, int y0, int y1) {
+  std::vector<Span> &column = mutableColumn(x);
+  // Первый отрезок, который касается [y0, y1] или лежит ниже него
+  auto first = std::find_if(column.begin(), column.end(), [&](const Span &s) {
+    return s.bottom + 1 >= y0;
+  });
+  auto last = first;
+  while (last != column.end() && last->top <= y1 + 1) {
+    y0 = std::min<int>(y0, last->top);
+    y1 = std::max<int>(y1, last->bottom);
+    ++last;
+  }
+  first = column.erase(first, last);
+  column.insert(first,
+                {static_cast<std::int16_t>(y0), static_cast<std::int16_t>(y1)});
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "OccupancyGrid.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Индекс поверхности: для каждого столбца отсортированный список сплошных
+// отрезков [top, bottom]. Первый отрезок дает верхний твердый пиксель,
+// остальные описывают нависания и пещеры.
+//
+// Столбцы сгруппированы в блоки по BLOCK_COLUMNS, как чанки в
+// OccupancyGrid: копия индекса делит блоки с оригиналом, а правка
+// разделенного блока сначала его копирует.
+class SurfaceIndex {
+public:
+  static constexpr int BLOCK_SHIFT = 6;
+  static constexpr int BLOCK_COLUMNS = 1 << BLOCK_SHIFT;
+  static constexpr int BLOCK_MASK = BLOCK_COLUMNS - 1;
+  // Предельный размер карты: y отрезков хранится в int16, а ширина
+  // ограничена, чтобы индекс и сетка оставались разумного размера. Этим же
+  // пределам подчиняются файлы карт, записи, трансляция и параметры утилит.
+  static constexpr int MAX_WIDTH = 1 << 20;
+  static constexpr int MAX_HEIGHT = 32767;
+
+  struct Span {
+    std::int16_t top;
+    std::int16_t bottom; // включительно
+  };
+
+  SurfaceIndex(int w, int h);
+
+  void rebuild(const OccupancyGrid &grid);
+
+  // Отрезок [y0, y1] столбца x становится пустым / твердым
+  void removeSpan(int x, int y0, int y1);
+  void addSpan(int x, int y0, int y1);
+
+  // Верхний твердый пиксель столбца или высота карты, если столбец пуст
+  int surfaceAt(int x) const {
+    const std::vector<Span> &column = spansAt(x);
+    return column.empty() ? height : column.front().top;
+  }
+
+  const std::vector<Span> &spansAt(int x) const {
+    return blocks[x >> BLOCK_SHIFT]->columns[x & BLOCK_MASK];
+  }
+
+private:
+  struct Block {
+    std::vector<Span> columns[BLOCK_COLUMNS];
+  };
+
+  // Столбец для записи: разделенный блок сначала копируется
+  std::vector<Span> &mutableColumn(int x);
+
+  int width, height;
+  std::vector<std::shared_ptr<Block>> blocks;
+};
@@ -0,0 +1,156 @@
+#include "TerrainGenerator.hpp"
+#include "../utils/GameTypes.hpp"
+#include "DiskMask.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Значение решетки шума в [0, 1]: хеш от номера слоя и узла
+float latticeValue(const RandomStream &layer, long long node) {
+  RandomStream stream = layer.split(static_cast<std::uint64_t>(node));
+  return stream.nextFloat();
+}
+} // namespace
+
+TerrainGenerator::Config TerrainGenerator::Config::forSize(int width,
+                                                           int height) {
+  Config config;
+  // 20 холмов на площадь окна 800x600
+  long long area = static_cast<long long>(width) * height;
+  config.hills = std::max(20, static_cast<int>(area * 20 / (800 * 600)));
+
+  if (width > 2 * GameTypes::WORLD_WIDTH) {
+    config.noiseLayers = 4;
+    config.noiseAmplitude = std::min(height / 16.0f, 240.0f);
+    config.noiseWavelength = 2048.0f;
+  }
+  return config;
+}
+
+TerrainGenerator::TerrainGenerator(ThreadPool *pool) : pool(pool) {}
+
+void TerrainGenerator::computeGround(int width, int height,
+                                     RandomStream noiseRng,
+                                     const Config &config,
+                                     Ground &ground) const {
+  ground.top.resize(width);
+  for (int x = 0; x < width; x++) {
+    float top = height - 120 + static_cast<int>(40 * sin(x * 0.008));
+
+    // Слои шума только поднимают землю: значение в [0, 1] с плавной
+    // интерполяцией между узлами решетки
+    float amplitude = config.noiseAmplitude;
+    float wavelength = config.noiseWavelength;
+    for (int layer = 0; layer < config.noiseLayers; layer++) {
+      RandomStream layerRng = noiseRng.split(layer);
+      float position = x / wavelength;
+      long long node = static_cast<long long>(position);
+      float t = position - node;
+      t = t * t * (3 - 2 * t);
+      float a = latticeValue(layerRng, node);
+      float b = latticeValue(layerRng, node + 1);
+      top -= amplitude * (a + (b - a) * t);
+      amplitude *= 0.5f;
+      wavelength *= 0.5f;
+    }
+    ground.top[x] = std::max(static_cast<int>(top), 0);
+  }
+
+  int blocks = (width + BLOCK - 1) / BLOCK;
+  ground.blockMin.assign(blocks, height);
+  ground.blockMax.assign(blocks, 0);
+  for (int x = 0; x < width; x++) {
+    ground.blockMin[x / BLOCK] = std::min(ground.blockMin[x / BLOCK],
+                                          ground.top[x]);
+    ground.blockMax[x / BLOCK] = std::max(ground.blockMax[x / BLOCK],
+                                          ground.top[x]);
+  }
+  ground.highest = *std::min_element(ground.blockMin.begin(),
+                                     ground.blockMin.end());
+  ground.lowest = *std::max_element(ground.blockMax.begin(),
+                                    ground.blockMax.end());
+}
+
+void TerrainGenerator::fillBand(OccupancyGrid &grid, int y0, int y1,
+                                const Ground &ground,
+                                const std::vector<Hill> &hills) const {
+  int width = grid.getWidth();
+
+  // Основной слой: ниже самого низкого края земли строка сплошная, в
+  // переходной зоне строка режется на отрезки по высотам столбцов
+  for (int y = std::max(y0, ground.highest); y < y1; y++) {
+    if (y >= ground.lowest) {
+      grid.fillSpan(y, 0, width - 1);
+      continue;
+    }
+    int runStart = -1;
+    auto solidColumn = [&](int x, bool solid) {
+      if (solid && runStart < 0) {
+        runStart = x;
+      } else if (!solid && runStart >= 0) {
+        grid.fillSpan(y, runStart, x - 1);
+        runStart = -1;
+      }
+    };
+    for (size_t block = 0; block < ground.blockMin.size(); block++) {
+      int x0 = static_cast<int>(block) * BLOCK;
+      if (y >= ground.blockMax[block]) {
+        solidColumn(x0, true);
+      } else if (y < ground.blockMin[block]) {
+        solidColumn(x0, false);
+      } else {
+        int x1 = std::min(x0 + BLOCK, width);
+        for (int x = x0; x < x1; x++)
+          solidColumn(x, ground.top[x] <= y);
+      }
+    }
+    solidColumn(width, false);
+  }
+
+  // Холмы — строки дисков, обрезанные по полосе и краям карты
+  for (const Hill &hill : hills) {
+    int top = std::max(hill.centerY - hill.radius, y0);
+    int bottom = std::min(hill.centerY + hill.radius, y1 - 1);
+    if (top > bottom)
+      continue;
+    const DiskMask &mask = DiskMask::forRadius(hill.radius);
+    for (int y = top; y <= bottom; y++) {
+      int halfWidth = mask.halfWidth(y - hill.centerY);
+      int x0 = std::max(hill.centerX - halfWidth, 0);
+      int x1 = std::min(hill.centerX + halfWidth, width - 1);
+      if (x0 <= x1)
+        grid.fillSpan(y, x0, x1);
+    }
+  }
+}
+
+void TerrainGenerator::generate(OccupancyGrid &grid, RandomStream rng,
+                                const Config &config) const {
+  int width = grid.getWidth();
+  int height = grid.getHeight();
+
+  // Шум берет свой подпоток, чтобы не сдвигать последовательность холмов
+  Ground ground;
+  computeGround(width, height, rng.split(0), config, ground);
+
+  std::vector<Hill> hills(config.hills);
+  for (Hill &hill : hills) {
+    hill.centerX = static_cast<int>(rng.nextFloat() * width);
+    hill.centerY = static_cast<int>(rng.nextFloat() * (height - 250)) + 100;
+    hill.radius = 15 + static_cast<int>(rng.nextFloat() * 35);
+  }
+
+  // Полоса — строка чанков: разные полосы не пишут в один чанк
+  for (int y0 = 0; y0 < height; y0 += OccupancyGrid::CHUNK_SIZE) {
+    int y1 = std::min(y0 + OccupancyGrid::CHUNK_SIZE, height);
+    auto band = [this, &grid, &ground, &hills, y0, y1] {
+      fillBand(grid, y0, y1, ground, hills);
+    };
+    if (pool)
+      pool->submit(band);
+    else
+      band();
+  }
+  if (pool)
+    pool->wait();
+}
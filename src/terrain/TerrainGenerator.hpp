@@ -0,0 +1,59 @@
+#pragma once
+#include "../utils/Random.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "OccupancyGrid.hpp"
+#include <vector>
+
+// Процедурная местность: основной слой — высота земли по столбцам
+// (синусоида и, на больших картах, слои шума), поверх него холмы-диски.
+// Все детали сначала описываются числами (высоты столбцов, центры и
+// радиусы холмов), затем сетка заполняется отрезками строк полосами по
+// высоте чанка. Полосы не делят чанки между собой и раздаются пулу потоков.
+// Заливка — объединение, поэтому порядок полос не важен и карта зависит
+// только от rng, а не от числа потоков.
+class TerrainGenerator {
+public:
+  struct Config {
+    int hills = 20;
+    // Слои шума высоты земли: каждый следующий вдвое короче по длине волны
+    // и вдвое ниже. 0 — только синусоида.
+    int noiseLayers = 0;
+    float noiseAmplitude = 0.0f;  // высота первого слоя, пиксели
+    float noiseWavelength = 0.0f; // длина волны первого слоя, пиксели
+
+    // Карта размера окна остается прежней. На широкой карте синусоида с
+    // периодом ~785 px повторяется десятки раз, поэтому к ней добавляется
+    // шум, а холмов становится больше пропорционально площади.
+    static Config forSize(int width, int height);
+  };
+
+  // Без пула все считается в вызывающем потоке. generate() ждет весь пул.
+  explicit TerrainGenerator(ThreadPool *pool);
+
+  // Заполняет пустую сетку
+  void generate(OccupancyGrid &grid, RandomStream rng,
+                const Config &config) const;
+
+private:
+  struct Hill {
+    int centerX, centerY, radius;
+  };
+
+  // Основной слой: верхняя твердая строка каждого столбца и ее пределы по
+  // блокам из BLOCK столбцов. Строка пересекает блок целиком, если она
+  // ниже его максимума, и не задевает, если выше минимума; по столбцам
+  // разбираются только блоки, через которые проходит край земли.
+  static constexpr int BLOCK = 64;
+  struct Ground {
+    std::vector<int> top;
+    std::vector<int> blockMin, blockMax;
+    int highest, lowest;
+  };
+
+  void computeGround(int width, int height, RandomStream noiseRng,
+                     const Config &config, Ground &ground) const;
+  void fillBand(OccupancyGrid &grid, int y0, int y1, const Ground &ground,
+                const std::vector<Hill> &hills) const;
+
+  ThreadPool *pool;
+};
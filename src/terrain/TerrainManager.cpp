@@ -1,99 +1,248 @@
 #include "TerrainManager.hpp"
-#include "../utils/GameTypes.hpp"
+#include "DiskMask.hpp"
+#include "TerrainGenerator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cmath>
-#include <random>
-
-TerrainManager::TerrainManager(int w, int h) : width(w), height(h) {
-  terrain.resize(height, std::vector<bool>(width, false));
-  terrainImage.create(width, height, sf::Color::Transparent);
-  generateTerrain();
-  updateTexture();
-}
-
-void TerrainManager::generateTerrain() {
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_real_distribution<> dis(0.0, 1.0);
-
-  // Создаем базовый ландшафт
-  for (int x = 0; x < width; x++) {
-    int groundHeight = height - 120 + static_cast<int>(40 * sin(x * 0.008));
-    for (int y = groundHeight; y < height; y++) {
-      terrain[y][x] = true;
-      terrainImage.setPixel(x, y, sf::Color(139, 69, 19));
-    }
-  }
+#include <limits>
+#include <utility>
+
+namespace {
+// Каждая сгенерированная карта получает свой номер, чтобы наблюдатели
+// (рендер) могли заметить подмену карты целиком
+std::atomic<std::uint64_t> nextMapVersion{1};
+
+bool sameDestruction(const TerrainDestruction &a, const TerrainDestruction &b) {
+  return a.centerX == b.centerX && a.centerY == b.centerY &&
+         a.radius == b.radius;
+}
+
+// Журнал a — начало журнала b
+bool isPrefix(const std::vector<TerrainDestruction> &a,
+              const std::vector<TerrainDestruction> &b) {
+  return a.size() <= b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), sameDestruction);
+}
+} // namespace
+
+TerrainManager::TerrainManager(int w, int h, RandomStream rng,
+                               ThreadPool *pool)
+    : terrain(w, h), surface(w, h), width(w), height(h), mapVersion(0),
+      destructionsHash(0) {
+  // Размер проверяют те, кто его принимает извне (параметры, файлы)
+  assert(w > 0 && w <= SurfaceIndex::MAX_WIDTH && h > 0 &&
+         h <= SurfaceIndex::MAX_HEIGHT);
+  generateTerrain(rng, pool);
+}
+
+TerrainManager::TerrainManager(std::shared_ptr<const MapFile> map)
+    : terrain(map->getWidth(), map->getHeight()),
+      surface(map->getWidth(), map->getHeight()), width(map->getWidth()),
+      height(map->getHeight()), mapVersion(0), destructionsHash(0),
+      source(std::move(map)) {
+  loadMap();
+}
 
-  // Добавляем холмы и препятствия
-  for (int i = 0; i < 20; i++) {
-    int centerX = static_cast<int>(dis(gen) * width);
-    int centerY = static_cast<int>(dis(gen) * (height - 250)) + 100;
-    int radius = 15 + static_cast<int>(dis(gen) * 35);
-
-    for (int x = centerX - radius; x <= centerX + radius; x++) {
-      for (int y = centerY - radius; y <= centerY + radius; y++) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-          float distance = sqrt((x - centerX) * (x - centerX) +
-                                (y - centerY) * (y - centerY));
-          if (distance <= radius) {
-            terrain[y][x] = true;
-            terrainImage.setPixel(x, y, sf::Color(139, 69, 19));
-          }
-        }
-      }
+TerrainManager &TerrainManager::operator=(const TerrainManager &other) {
+  bool continues = other.mapVersion == mapVersion &&
+                   isPrefix(destructions, other.destructions);
+  terrain = other.terrain;
+  surface = other.surface;
+  width = other.width;
+  height = other.height;
+  destructions = other.destructions;
+  destructionsHash = other.destructionsHash;
+  source = other.source;
+  mapVersion = continues ? other.mapVersion : nextMapVersion++;
+  return *this;
+}
+
+void TerrainManager::loadMap() {
+  terrain.clear();
+  destructions.clear();
+  destructionsHash = 0;
+  mapVersion = nextMapVersion++;
+
+  // Пустые и сплошные чанки раскодировать не нужно, так что работа идет
+  // только по чанкам с краем поверхности
+  for (int cy = 0; cy < source->getChunksY(); cy++) {
+    for (int cx = 0; cx < source->getChunksX(); cx++) {
+      terrain.setChunk(cx, cy, source->decodeChunk(cx, cy));
     }
   }
+  surface.rebuild(terrain);
+}
+
+bool TerrainManager::saveMap(const std::string &path) const {
+  return MapFile::save(path, terrain);
+}
+
+void TerrainManager::generateTerrain(RandomStream rng, ThreadPool *pool) {
+  terrain.clear();
+  destructions.clear();
+  destructionsHash = 0;
+  source.reset();
+  mapVersion = nextMapVersion++;
+
+  TerrainGenerator(pool).generate(terrain, rng,
+                                  TerrainGenerator::Config::forSize(width,
+                                                                    height));
+  surface.rebuild(terrain);
 }
 
 void TerrainManager::destroyTerrain(int centerX, int centerY, int radius) {
-  for (int x = centerX - radius; x <= centerX + radius; x++) {
-    for (int y = centerY - radius; y <= centerY + radius; y++) {
-      if (x >= 0 && x < width && y >= 0 && y < height) {
-        float distance =
-            sqrt((x - centerX) * (x - centerX) + (y - centerY) * (y - centerY));
-        if (distance <= radius) {
-          terrain[y][x] = false;
-          terrainImage.setPixel(x, y, sf::Color::Transparent);
-        }
-      }
-    }
+  stampDisk(centerX, centerY, radius, false);
+
+  // Поправляем индекс поверхности только в задетых столбцах
+  const DiskMask &mask = DiskMask::forRadius(radius);
+  int x0 = std::max(centerX - radius, 0);
+  int x1 = std::min(centerX + radius, width - 1);
+  for (int x = x0; x <= x1; x++) {
+    int halfHeight = mask.halfWidth(x - centerX);
+    int y0 = std::max(centerY - halfHeight, 0);
+    int y1 = std::min(centerY + halfHeight, height - 1);
+    if (y0 <= y1)
+      surface.removeSpan(x, y0, y1);
+  }
+
+  destructions.push_back({centerX, centerY, radius});
+  std::uint64_t center =
+      static_cast<std::uint32_t>(centerX) |
+      static_cast<std::uint64_t>(static_cast<std::uint32_t>(centerY)) << 32;
+  destructionsHash =
+      RandomStream(destructionsHash ^ center).split(radius).nextU64();
+}
+
+void TerrainManager::writeDestructions(ByteWriter &out) const {
+  out.varint(destructions.size());
+  for (const TerrainDestruction &d : destructions) {
+    out.svarint(d.centerX);
+    out.svarint(d.centerY);
+    out.varint(static_cast<std::uint32_t>(d.radius));
+  }
+}
+
+bool TerrainManager::readDestructions(
+    ByteReader &in, std::vector<TerrainDestruction> &journal) {
+  std::uint64_t count = in.varint();
+  // Запись журнала занимает хотя бы три байта
+  if (!in.ok() || count > in.remaining() / 3)
+    return false;
+  journal.resize(count);
+  for (TerrainDestruction &d : journal) {
+    std::int64_t x = in.svarint();
+    std::int64_t y = in.svarint();
+    std::uint64_t radius = in.varint();
+    if (x < -MAX_COORDINATE || x > MAX_COORDINATE || y < -MAX_COORDINATE ||
+        y > MAX_COORDINATE || radius > MAX_DESTRUCTION_RADIUS)
+      return false;
+    d.centerX = static_cast<int>(x);
+    d.centerY = static_cast<int>(y);
+    d.radius = static_cast<int>(radius);
   }
-  updateTexture();
+  return in.ok();
 }
 
-void TerrainManager::updateTexture() {
-  terrainTexture.loadFromImage(terrainImage);
-  terrainSprite.setTexture(terrainTexture);
+bool TerrainManager::catchUp(const std::vector<TerrainDestruction> &journal) {
+  if (!isPrefix(destructions, journal))
+    return false;
+  for (std::size_t i = destructions.size(); i < journal.size(); i++)
+    destroyTerrain(journal[i].centerX, journal[i].centerY, journal[i].radius);
+  return true;
+}
+
+void TerrainManager::stampDisk(int centerX, int centerY, int radius,
+                               bool solid) {
+  const DiskMask &mask = DiskMask::forRadius(radius);
+  int y0 = std::max(centerY - radius, 0);
+  int y1 = std::min(centerY + radius, height - 1);
+  for (int y = y0; y <= y1; y++) {
+    int halfWidth = mask.halfWidth(y - centerY);
+    int x0 = std::max(centerX - halfWidth, 0);
+    int x1 = std::min(centerX + halfWidth, width - 1);
+    if (x0 > x1)
+      continue;
+    if (solid)
+      terrain.fillSpan(y, x0, x1);
+    else
+      terrain.clearSpan(y, x0, x1);
+  }
 }
 
 bool TerrainManager::isColliding(int x, int y) const {
   if (x < 0 || x >= width || y < 0 || y >= height)
     return true;
-  return terrain[y][x];
+  return terrain.test(x, y);
 }
 
 bool TerrainManager::isColliding(sf::Vector2f pos, int radius) const {
-  for (int dx = -radius; dx <= radius; dx++) {
-    for (int dy = -radius; dy <= radius; dy++) {
-      if (dx * dx + dy * dy <= radius * radius) {
-        if (isColliding(static_cast<int>(pos.x) + dx,
-                        static_cast<int>(pos.y) + dy)) {
-          return true;
-        }
-      }
-    }
+  int centerX = static_cast<int>(pos.x);
+  int centerY = static_cast<int>(pos.y);
+
+  // Любая клетка круга за пределами карты считается столкновением
+  if (centerY - radius < 0 || centerY + radius >= height ||
+      centerX - radius < 0 || centerX + radius >= width)
+    return true;
+
+  // Строки круга берем из таблицы и сверяем со словами местности целиком
+  const DiskMask &mask = DiskMask::forRadius(radius);
+  for (int dy = -radius; dy <= radius; dy++) {
+    int halfWidth = mask.halfWidth(dy);
+    if (terrain.anyInSpan(centerY + dy, centerX - halfWidth,
+                          centerX + halfWidth))
+      return true;
   }
   return false;
 }
 
-int TerrainManager::findGroundLevel(int x) const {
-  for (int y = 0; y < height; y++) {
-    if (terrain[y][x])
-      return y;
+bool TerrainManager::findFirstCollision(sf::Vector2f from, sf::Vector2f to,
+                                        sf::Vector2f &hitPoint) const {
+  int cellX = static_cast<int>(std::floor(from.x));
+  int cellY = static_cast<int>(std::floor(from.y));
+  if (isColliding(cellX, cellY)) {
+    hitPoint = from;
+    return true;
   }
-  return height;
+
+  // Обход клеток вдоль отрезка (DDA): на каждом шаге переходим через
+  // ближайшую вертикальную или горизонтальную границу клетки
+  sf::Vector2f delta = to - from;
+  const float infinity = std::numeric_limits<float>::infinity();
+  int stepX = delta.x > 0 ? 1 : -1;
+  int stepY = delta.y > 0 ? 1 : -1;
+  float tDeltaX = delta.x != 0 ? std::abs(1.0f / delta.x) : infinity;
+  float tDeltaY = delta.y != 0 ? std::abs(1.0f / delta.y) : infinity;
+  float tMaxX = delta.x > 0   ? (cellX + 1 - from.x) * tDeltaX
+                : delta.x < 0 ? (from.x - cellX) * tDeltaX
+                              : infinity;
+  float tMaxY = delta.y > 0   ? (cellY + 1 - from.y) * tDeltaY
+                : delta.y < 0 ? (from.y - cellY) * tDeltaY
+                              : infinity;
+
+  int steps = std::abs(static_cast<int>(std::floor(to.x)) - cellX) +
+              std::abs(static_cast<int>(std::floor(to.y)) - cellY);
+  for (int i = 0; i < steps; i++) {
+    float t;
+    if (tMaxX < tMaxY) {
+      cellX += stepX;
+      t = tMaxX;
+      tMaxX += tDeltaX;
+    } else {
+      cellY += stepY;
+      t = tMaxY;
+      tMaxY += tDeltaY;
+    }
+    if (isColliding(cellX, cellY)) {
+      hitPoint = from + delta * std::min(t, 1.0f);
+      return true;
+    }
+  }
+  return false;
 }
 
-void TerrainManager::draw(sf::RenderWindow &window) {
-  window.draw(terrainSprite);
+int TerrainManager::findGroundLevel(int x) const {
+  if (x < 0 || x >= width)
+    return height;
+  return surface.surfaceAt(x);
 }
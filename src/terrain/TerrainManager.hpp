@@ -1,25 +1,89 @@
 #pragma once
-#include <SFML/Graphics.hpp>
+#include "../utils/BinaryIO.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "MapFile.hpp"
+#include "OccupancyGrid.hpp"
+#include "SurfaceIndex.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
+// Запись о разрушении местности: центр и радиус воронки
+struct TerrainDestruction {
+  int centerX, centerY, radius;
+};
+
 class TerrainManager {
 private:
-  std::vector<std::vector<bool>> terrain;
+  OccupancyGrid terrain;
+  SurfaceIndex surface;
   int width, height;
-  sf::Image terrainImage;
-  sf::Texture terrainTexture;
-  sf::Sprite terrainSprite;
+
+  // Журнал разрушений текущей карты: по нему наблюдатели догоняют изменения
+  std::uint64_t mapVersion;
+  std::vector<TerrainDestruction> destructions;
+  std::uint64_t destructionsHash; // хеш журнала, копится по записи
+
+  // Файл карты, из которого загружена местность; nullptr — сгенерирована
+  std::shared_ptr<const MapFile> source;
+
+  void stampDisk(int centerX, int centerY, int radius, bool solid);
 
 public:
-  TerrainManager(int w, int h);
+  // Воронка больше карты наибольшей высоты и точка дальше нескольких
+  // ширин карты — признак испорченного снимка или журнала
+  static constexpr int MAX_DESTRUCTION_RADIUS = SurfaceIndex::MAX_HEIGHT;
+  static constexpr int MAX_COORDINATE = 4 * SurfaceIndex::MAX_WIDTH;
+
+  // С пулом полосы карты заполняются параллельно; карта от этого не
+  // зависит
+  TerrainManager(int w, int h, RandomStream rng, ThreadPool *pool = nullptr);
+  // Местность из открытого файла карты; размер берется из файла
+  explicit TerrainManager(std::shared_ptr<const MapFile> map);
 
-  void generateTerrain();
+  // Копия делит с оригиналом чанки сетки и блоки индекса поверхности;
+  // отделяются только те, что потом заденет взрыв. При присваивании
+  // версия карты сохраняется, если журнал разрушений этой местности —
+  // начало журнала присваиваемой: наблюдатели дорисуют остаток. Иначе
+  // для них карта подменена целиком.
+  TerrainManager(const TerrainManager &) = default;
+  TerrainManager(TerrainManager &&) = default;
+  TerrainManager &operator=(const TerrainManager &other);
+
+  void generateTerrain(RandomStream rng, ThreadPool *pool = nullptr);
+  // Заново раскладывает чанки из файла карты, стирая все воронки
+  void loadMap();
+  bool saveMap(const std::string &path) const;
+  const std::shared_ptr<const MapFile> &getSource() const { return source; }
   void destroyTerrain(int centerX, int centerY, int radius);
-  void updateTexture();
+
+  // Журнал разрушений: вместе с картой он целиком задает местность
+  void writeDestructions(ByteWriter &out) const;
+  static bool readDestructions(ByteReader &in,
+                               std::vector<TerrainDestruction> &journal);
+  // Доводит местность до журнала той же карты. false — текущий журнал не
+  // начало нового, и местность не менялась.
+  bool catchUp(const std::vector<TerrainDestruction> &journal);
 
   bool isColliding(int x, int y) const;
   bool isColliding(sf::Vector2f pos, int radius = 15) const;
+  // Первая твердая клетка на отрезке from -> to; точка входа в hitPoint
+  bool findFirstCollision(sf::Vector2f from, sf::Vector2f to,
+                          sf::Vector2f &hitPoint) const;
   int findGroundLevel(int x) const;
+  const SurfaceIndex &getSurface() const { return surface; }
 
-  void draw(sf::RenderWindow &window);
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  const OccupancyGrid &getGrid() const { return terrain; }
+  std::uint64_t getMapVersion() const { return mapVersion; }
+  const std::vector<TerrainDestruction> &getDestructions() const {
+    return destructions;
+  }
+  // Карта плюс журнал задают местность, поэтому для сверки двух копий
+  // одной карты хватает хеша журнала вместо всех слов сетки
+  std::uint64_t getDestructionsHash() const { return destructionsHash; }
 };
@@ -0,0 +1,439 @@
+// Микробенчмарки горячих мест симуляции на фиксированных данных.
+//
+//   bench [--repetitions N] [--filter text] [--seed S] [--json file]
+//         [--compare old.json]
+//
+// Каждый замер готовит свежее состояние из seed (вне замера) и прогоняет
+// на нем фиксированный набор операций; после одного прогрева замер
+// повторяется N раз. Печатаются медиана, MAD (медиана отклонений от
+// медианы) и минимум времени на операцию. --json пишет результаты по
+// строке на бенчмарк, --compare сравнивает с таким файлом от другого
+// коммита: разница меньше трех MAD считается шумом.
+#include "../entities/ProjectilePool.hpp"
+#include "../entities/Worm.hpp"
+#include "../game/PlayerInput.hpp"
+#include "../game/Simulation.hpp"
+#include "../game/TrajectoryPreview.hpp"
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Карта крупнее окна: ближе к большим боям, чем 800x600
+constexpr int WORLD_WIDTH = 1600;
+constexpr int WORLD_HEIGHT = 1000;
+constexpr float TICK = 1.0f / GameTypes::SIM_TICK_RATE;
+
+const char *WEAPON_NAMES[GameTypes::WEAPON_COUNT] = {"bazooka", "sniper",
+                                                     "frag"};
+
+struct BenchConfig {
+  int repetitions = 15;
+  std::string filter;
+  std::uint64_t seed = 1;
+  std::string jsonPath;
+  std::string comparePath;
+};
+
+// Прогон возвращает число выполненных операций
+using Run = std::function<long()>;
+
+struct Benchmark {
+  std::string name;
+  // Готовит состояние (вне замера) и возвращает прогон по нему
+  std::function<Run()> prepare;
+};
+
+struct Result {
+  std::string name;
+  long operations = 0;
+  std::vector<double> samples; // нс на операцию
+  double median = 0.0;
+  double mad = 0.0;
+  double min = 0.0;
+};
+
+// Сюда стекаются результаты операций, чтобы компилятор их не выбросил
+volatile std::uint64_t sink;
+
+double median(std::vector<double> values) {
+  std::size_t middle = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + middle, values.end());
+  double upper = values[middle];
+  if (values.size() % 2 == 1)
+    return upper;
+  return (upper + *std::max_element(values.begin(),
+                                    values.begin() + middle)) /
+         2.0;
+}
+
+TerrainManager makeTerrain(std::uint64_t seed) {
+  return TerrainManager(WORLD_WIDTH, WORLD_HEIGHT,
+                        RandomStream(seed).split(RandomStreams::TERRAIN));
+}
+
+// Точка в воздухе над поверхностью: там снаряды и червяки начинают путь
+sf::Vector2f pointAbove(const TerrainManager &terrain, RandomStream &rng,
+                        float minHeight, float maxHeight) {
+  int x = rng.uniformInt(40, WORLD_WIDTH - 40);
+  float y = terrain.findGroundLevel(x) - rng.uniform(minHeight, maxHeight);
+  return sf::Vector2f(static_cast<float>(x), std::max(y, 0.0f));
+}
+
+Benchmark generateBenchmark(std::uint64_t seed) {
+  return {"terrain.generateTerrain", [seed]() -> Run {
+            auto terrain = std::make_shared<TerrainManager>(makeTerrain(seed));
+            return [terrain, seed]() -> long {
+              RandomStream maps(seed);
+              for (int i = 0; i < 10; i++)
+                terrain->generateTerrain(maps.split(i));
+              sink = sink + terrain->getMapVersion();
+              return 10;
+            };
+          }};
+}
+
+// Точки по всей карте: и в воздухе, и в земле
+Benchmark pointBenchmark(std::uint64_t seed, const TerrainManager &terrain) {
+  return {"terrain.isColliding.point", [seed, &terrain]() -> Run {
+            RandomStream rng = RandomStream(seed).split(10);
+            auto points = std::make_shared<std::vector<sf::Vector2i>>();
+            for (int i = 0; i < 1000000; i++)
+              points->emplace_back(rng.uniformInt(0, WORLD_WIDTH - 1),
+                                   rng.uniformInt(0, WORLD_HEIGHT - 1));
+            return [points, &terrain]() -> long {
+              std::uint64_t hits = 0;
+              for (const sf::Vector2i &point : *points)
+                hits += terrain.isColliding(point.x, point.y);
+              sink = sink + hits;
+              return static_cast<long>(points->size());
+            };
+          }};
+}
+
+// Круги червяков у поверхности, где проверка не решается по одному чанку
+Benchmark circleBenchmark(std::uint64_t seed, const TerrainManager &terrain) {
+  return {"terrain.isColliding.circle", [seed, &terrain]() -> Run {
+            RandomStream rng = RandomStream(seed).split(11);
+            auto points = std::make_shared<std::vector<sf::Vector2f>>();
+            for (int i = 0; i < 200000; i++)
+              points->push_back(pointAbove(terrain, rng, -30.0f, 30.0f));
+            return [points, &terrain]() -> long {
+              std::uint64_t hits = 0;
+              for (const sf::Vector2f &point : *points)
+                hits += terrain.isColliding(point, GameTypes::WORM_RADIUS);
+              sink = sink + hits;
+              return static_cast<long>(points->size());
+            };
+          }};
+}
+
+Benchmark groundBenchmark(std::uint64_t seed, const TerrainManager &terrain) {
+  return {"terrain.findGroundLevel", [seed, &terrain]() -> Run {
+            RandomStream rng = RandomStream(seed).split(12);
+            auto columns = std::make_shared<std::vector<int>>();
+            for (int i = 0; i < 1000000; i++)
+              columns->push_back(rng.uniformInt(0, WORLD_WIDTH - 1));
+            return [columns, &terrain]() -> long {
+              std::uint64_t levels = 0;
+              for (int x : *columns)
+                levels += terrain.findGroundLevel(x);
+              sink = sink + levels;
+              return static_cast<long>(columns->size());
+            };
+          }};
+}
+
+struct Crater {
+  int x, y, radius;
+};
+
+// Воронки разного радиуса у поверхности, на свежей карте каждый раз
+Benchmark destroyBenchmark(std::uint64_t seed) {
+  return {"terrain.destroyTerrain", [seed]() -> Run {
+            auto terrain = std::make_shared<TerrainManager>(makeTerrain(seed));
+            RandomStream rng = RandomStream(seed).split(13);
+            auto craters = std::make_shared<std::vector<Crater>>();
+            for (int i = 0; i < 5000; i++) {
+              sf::Vector2f center = pointAbove(*terrain, rng, -40.0f, 20.0f);
+              craters->push_back({static_cast<int>(center.x),
+                                  static_cast<int>(center.y),
+                                  rng.uniformInt(5, 45)});
+            }
+            return [terrain, craters]() -> long {
+              for (const Crater &crater : *craters)
+                terrain->destroyTerrain(crater.x, crater.y, crater.radius);
+              sink = sink + terrain->getDestructionsHash();
+              return static_cast<long>(craters->size());
+            };
+          }};
+}
+
+// Залп снарядов одного оружия летит до последнего взрыва; операция —
+// обновление живого снаряда за тик, включая взрывы и осколки
+Benchmark projectileBenchmark(std::uint64_t seed, int weapon) {
+  auto type = static_cast<GameTypes::WeaponType>(weapon);
+  return {std::string("projectile.update.") + WEAPON_NAMES[weapon],
+          [seed, type, weapon]() -> Run {
+            auto terrain = std::make_shared<TerrainManager>(makeTerrain(seed));
+            auto pool = std::make_shared<ProjectilePool>();
+            RandomStream rng = RandomStream(seed).split(20 + weapon);
+            // Осколков у гранаты много, ей хватает меньшего залпа
+            int volley =
+                type == GameTypes::WeaponType::FRAG_GRENADE ? 200 : 1000;
+            for (int i = 0; i < volley; i++) {
+              sf::Vector2f position = pointAbove(*terrain, rng, 50.0f, 300.0f);
+              float angle = rng.uniform(-2.8f, -0.3f); // вверх-вбок
+              float speed = GameTypes::launchSpeed(type, rng.uniform(0, 100));
+              pool->spawn(position,
+                          sf::Vector2f(std::cos(angle), std::sin(angle)) *
+                              speed,
+                          i % 4, type, rng.split(i));
+            }
+            return [terrain, pool]() -> long {
+              long updates = 0;
+              for (int tick = 0; tick < 1200 && !pool->empty(); tick++) {
+                std::size_t liveCount = pool->size();
+                for (std::size_t i = 0; i < liveCount; i++) {
+                  std::uint32_t slot = pool->getLiveSlots()[i];
+                  updates += pool->activeFlags[slot];
+                  pool->update(slot, TICK, *terrain);
+                }
+                pool->releaseInactive();
+              }
+              sink = sink + terrain->getDestructionsHash();
+              return updates;
+            };
+          }};
+}
+
+// Червяки падают на поверхность, ходят и прыгают; операция — update одного
+// червяка за тик
+Benchmark wormBenchmark(std::uint64_t seed) {
+  return {"worm.update", [seed]() -> Run {
+            auto terrain = std::make_shared<TerrainManager>(makeTerrain(seed));
+            auto worms = std::make_shared<std::vector<Worm>>();
+            RandomStream rng = RandomStream(seed).split(30);
+            for (int i = 0; i < 400; i++) {
+              sf::Vector2f position = pointAbove(*terrain, rng, 20.0f, 120.0f);
+              worms->emplace_back(position.x, position.y, i % 8);
+              worms->back().isMyTurn = true;
+            }
+            return [terrain, worms]() -> long {
+              const int ticks = 300;
+              for (int tick = 0; tick < ticks; tick++) {
+                for (std::size_t i = 0; i < worms->size(); i++) {
+                  Worm &worm = (*worms)[i];
+                  if ((tick + i) % 20 == 0)
+                    worm.move((tick / 20 + i) % 2 ? 1.0f : -1.0f);
+                  if ((tick + i) % 90 == 0)
+                    worm.jump(sf::Vector2f(0.5f, -0.85f));
+                  worm.update(TICK, *terrain);
+                }
+              }
+              sink = sink + static_cast<std::uint64_t>((*worms)[0].position.x);
+              return ticks * static_cast<long>(worms->size());
+            };
+          }};
+}
+
+// Предпросмотр траектории активного червяка; прицел меняется каждую
+// операцию, так что кеш не срабатывает и путь считается заново
+Benchmark trajectoryBenchmark(std::uint64_t seed, int weapon) {
+  return {std::string("trajectory.") + WEAPON_NAMES[weapon],
+          [seed, weapon]() -> Run {
+            auto simulation = std::make_shared<Simulation>(
+                WORLD_WIDTH, WORLD_HEIGHT, seed, BattleConfig());
+            PlayerInput select;
+            select.selectWeapon = true;
+            select.weapon = static_cast<GameTypes::WeaponType>(weapon);
+            simulation->step(select, TICK);
+            return [simulation]() -> long {
+              TrajectoryPreview preview;
+              PlayerInput input;
+              long computed = 0;
+              std::uint64_t points = 0;
+              for (int i = 0; i < 5000; i++) {
+                float angle = -3.1f + 3.0f * (i % 200) / 200.0f;
+                input.aimDirection = sf::Vector2f(std::cos(angle),
+                                                  std::sin(angle));
+                input.aimPower = static_cast<float>(20 + i % 80);
+                computed += preview.update(*simulation, input);
+                points += preview.getPoints().size();
+              }
+              sink = sink + points;
+              return computed;
+            };
+          }};
+}
+
+Result measure(const Benchmark &benchmark, int repetitions) {
+  using Clock = std::chrono::steady_clock;
+  Result result;
+  result.name = benchmark.name;
+  // Первый прогон — прогрев кешей и аллокатора, в счет не идет
+  for (int i = -1; i < repetitions; i++) {
+    Run run = benchmark.prepare();
+    auto start = Clock::now();
+    long operations = run();
+    double nanoseconds =
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count();
+    if (i < 0)
+      continue;
+    result.operations = operations;
+    result.samples.push_back(nanoseconds / std::max(operations, 1L));
+  }
+
+  result.median = median(result.samples);
+  std::vector<double> deviations;
+  for (double sample : result.samples)
+    deviations.push_back(std::fabs(sample - result.median));
+  result.mad = median(deviations);
+  result.min = *std::min_element(result.samples.begin(), result.samples.end());
+  return result;
+}
+
+bool writeJson(const std::string &path, const BenchConfig &config,
+               const std::vector<Result> &results) {
+  FILE *json = std::fopen(path.c_str(), "w");
+  if (!json)
+    return false;
+  std::fprintf(json,
+               "{\"schema\": 1, \"seed\": %llu, \"repetitions\": %d, "
+               "\"world\": [%d, %d],\n\"benchmarks\": [\n",
+               static_cast<unsigned long long>(config.seed),
+               config.repetitions, WORLD_WIDTH, WORLD_HEIGHT);
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    std::fprintf(json,
+                 "{\"name\": \"%s\", \"operations\": %ld, \"median_ns\": "
+                 "%.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, \"samples_ns\": [",
+                 result.name.c_str(), result.operations, result.median,
+                 result.mad, result.min);
+    for (std::size_t s = 0; s < result.samples.size(); s++)
+      std::fprintf(json, "%s%.3f", s == 0 ? "" : ", ", result.samples[s]);
+    std::fprintf(json, "]}%s\n", i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(json, "]}\n");
+  return std::fclose(json) == 0;
+}
+
+// Читает только то, что пишет writeJson: бенчмарк на строке
+bool readJson(const std::string &path, std::map<std::string, Result> &out) {
+  FILE *json = std::fopen(path.c_str(), "r");
+  if (!json)
+    return false;
+  char line[8192];
+  while (std::fgets(line, sizeof(line), json)) {
+    const char *name = std::strstr(line, "\"name\": \"");
+    const char *median = std::strstr(line, "\"median_ns\": ");
+    const char *mad = std::strstr(line, "\"mad_ns\": ");
+    if (!name || !median || !mad)
+      continue;
+    name += std::strlen("\"name\": \"");
+    const char *nameEnd = std::strchr(name, '"');
+    if (!nameEnd)
+      continue;
+    Result result;
+    result.name.assign(name, nameEnd);
+    result.median = std::atof(median + std::strlen("\"median_ns\": "));
+    result.mad = std::atof(mad + std::strlen("\"mad_ns\": "));
+    out[result.name] = result;
+  }
+  std::fclose(json);
+  return true;
+}
+
+bool parseArgs(int argc, char **argv, BenchConfig &config) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string arg = argv[i];
+    if (arg == "--repetitions") {
+      config.repetitions = std::max(1, std::atoi(argv[i + 1]));
+    } else if (arg == "--filter") {
+      config.filter = argv[i + 1];
+    } else if (arg == "--seed") {
+      config.seed = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (arg == "--json") {
+      config.jsonPath = argv[i + 1];
+    } else if (arg == "--compare") {
+      config.comparePath = argv[i + 1];
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    std::fprintf(stderr,
+                 "usage: %s [--repetitions N] [--filter text] [--seed S] "
+                 "[--json file] [--compare old.json]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  std::map<std::string, Result> baseline;
+  if (!config.comparePath.empty() && !readJson(config.comparePath, baseline)) {
+    std::perror(config.comparePath.c_str());
+    return 1;
+  }
+
+  // Общая карта для бенчмарков, которые ее только читают
+  const TerrainManager terrain = makeTerrain(config.seed);
+  std::vector<Benchmark> benchmarks = {
+      generateBenchmark(config.seed), pointBenchmark(config.seed, terrain),
+      circleBenchmark(config.seed, terrain),
+      groundBenchmark(config.seed, terrain), destroyBenchmark(config.seed)};
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++)
+    benchmarks.push_back(projectileBenchmark(config.seed, w));
+  benchmarks.push_back(wormBenchmark(config.seed));
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++)
+    benchmarks.push_back(trajectoryBenchmark(config.seed, w));
+
+  std::printf("%-28s %10s %12s %9s %12s\n", "benchmark", "ops",
+              "median ns", "MAD", "min ns");
+  std::vector<Result> results;
+  for (const Benchmark &benchmark : benchmarks) {
+    if (benchmark.name.find(config.filter) == std::string::npos)
+      continue;
+    Result result = measure(benchmark, config.repetitions);
+    std::printf("%-28s %10ld %12.2f %8.1f%% %12.2f", result.name.c_str(),
+                result.operations, result.median,
+                100.0 * result.mad / result.median, result.min);
+
+    auto old = baseline.find(result.name);
+    if (old != baseline.end()) {
+      double change = 100.0 * (result.median / old->second.median - 1.0);
+      bool noise = std::fabs(result.median - old->second.median) <
+                   3.0 * std::max(result.mad, old->second.mad);
+      std::printf("  %+6.1f%%%s", change, noise ? " (noise)" : "");
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+    results.push_back(result);
+  }
+
+  if (!config.jsonPath.empty() &&
+      !writeJson(config.jsonPath, config, results)) {
+    std::perror(config.jsonPath.c_str());
+    return 1;
+  }
+  return 0;
+}
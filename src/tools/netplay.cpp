@@ -0,0 +1,247 @@
+// Проверка сетевой игры без окна: несколько участников lockstep в одном
+// процессе обмениваются вводом через настоящие UDP-сокеты на loopback.
+//
+//   netplay [--peers N] [--delay D] [--latency MS] [--jitter MS]
+//           [--loss P] [--seed S] [--teams N] [--worms M]
+//           [--max-ticks K] [--inject-desync TICK]
+//
+// Время виртуальное, с шагом в миллисекунду, а задержки и потери пакетов
+// изображает LinkShim, так что прогон с секундной задержкой занимает
+// столько же, сколько без нее. За команды играют боты, каждый на своем
+// участнике. В конце печатаются хеши состояний (должны совпасть), байты
+// на тик, доля времени в ожидании ввода, время подтверждения и задержка
+// ввода, которую сеанс счел бы достаточной.
+//
+// --inject-desync TICK сбивает последнего участника с того же ввода на
+// этом тике: проверка, что расхождение замечают все. Код возврата 0,
+// если итог такой, как ожидалось.
+#include "../ai/ScriptedShooter.hpp"
+#include "../game/Simulation.hpp"
+#include "../net/Lockstep.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr double CLOCK_STEP = 0.001;
+// Столько тиков подряд сбитый участник идет вправо
+constexpr int DESYNC_TICKS = 60;
+
+struct NetplayConfig {
+  int peers = 2;
+  int delay = 3;
+  LinkConditions link;
+  std::uint64_t seed = 1;
+  BattleConfig battle;
+  int maxTicks = 60 * 60 * 10;
+  int injectDesync = -1;
+};
+
+struct NetPeer {
+  std::unique_ptr<LockstepSession> session;
+  std::unique_ptr<Simulation> simulation;
+  std::unique_ptr<ScriptedShooter> bot;
+  double accumulator = 0.0;
+  double stalled = 0.0; // время, когда тик пора было исполнять, а ввода нет
+  bool done = false;
+};
+
+// Тик участника, если ввод всех пришел; false — ждем сеть
+bool stepPeer(const NetplayConfig &config, NetPeer &peer, int index,
+              float tickDuration, double now) {
+  LockstepSession &session = *peer.session;
+  Simulation &simulation = *peer.simulation;
+  if (!session.ready())
+    return false;
+
+  int tick = session.getTick();
+  PlayerInput input =
+      session.inputOf(session.ownerOf(simulation.getActiveWorm().teamId));
+  if (index == config.peers - 1 && config.injectDesync >= 0 &&
+      tick >= config.injectDesync && tick < config.injectDesync + DESYNC_TICKS)
+    input.move = 1.0f;
+  simulation.step(input, tickDuration);
+
+  // Бот решает по состоянию после тика, его ввод исполнится через delay
+  PlayerInput local;
+  if (session.ownerOf(simulation.getActiveWorm().teamId) == index)
+    local = peer.bot->decide(simulation);
+  session.advance(local, simulation.checksum(), now);
+
+  // После расхождения матчи у участников разные, дальше играть нечего
+  if (simulation.isGameOver() || session.getTick() >= config.maxTicks ||
+      session.getDesyncTick() >= 0)
+    peer.done = true;
+  return true;
+}
+
+bool parseArgs(int argc, char **argv, NetplayConfig &config) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+    if (arg == "--peers") {
+      config.peers = std::max(2, std::min(8, std::atoi(value)));
+    } else if (arg == "--delay") {
+      config.delay = std::max(1, std::atoi(value));
+    } else if (arg == "--latency") {
+      config.link.latency = std::max(0.0f, std::strtof(value, nullptr)) / 1000;
+    } else if (arg == "--jitter") {
+      config.link.jitter = std::max(0.0f, std::strtof(value, nullptr)) / 1000;
+    } else if (arg == "--loss") {
+      config.link.loss =
+          std::max(0.0f, std::min(0.9f, std::strtof(value, nullptr)));
+    } else if (arg == "--seed") {
+      config.seed = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--teams") {
+      config.battle.teams = std::max(2, std::atoi(value));
+    } else if (arg == "--worms") {
+      config.battle.wormsPerTeam = std::max(1, std::atoi(value));
+    } else if (arg == "--max-ticks") {
+      config.maxTicks = std::max(1, std::atoi(value));
+    } else if (arg == "--inject-desync") {
+      config.injectDesync = std::max(0, std::atoi(value));
+    } else {
+      return false;
+    }
+  }
+  // У каждого участника хотя бы одна команда
+  config.battle.teams = std::max(config.battle.teams, config.peers);
+  return config.battle.isValid();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  NetplayConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    std::fprintf(stderr,
+                 "usage: %s [--peers N] [--delay D] [--latency MS] "
+                 "[--jitter MS] [--loss P] [--seed S] [--teams N] "
+                 "[--worms M] [--max-ticks K] [--inject-desync TICK]\n",
+                 argv[0]);
+    return 1;
+  }
+  float tickDuration = 1.0f / GameTypes::SIM_TICK_RATE;
+
+  std::vector<NetPeer> peers(config.peers);
+  for (int i = 0; i < config.peers; i++) {
+    LockstepConfig session;
+    session.localPeer = i;
+    session.peers.resize(config.peers);
+    session.inputDelay = config.delay;
+    session.tickDuration = tickDuration;
+    session.link = config.link;
+    session.linkSeed = config.seed;
+    peers[i].session.reset(new LockstepSession(session));
+    if (!peers[i].session->open()) {
+      std::perror("netplay: cannot open a UDP socket");
+      return 1;
+    }
+    peers[i].simulation.reset(new Simulation(
+        GameTypes::WORLD_WIDTH, GameTypes::WORLD_HEIGHT, config.seed,
+        config.battle));
+    peers[i].bot.reset(new ScriptedShooter(
+        ScriptedShooter::Mode::AIMED,
+        RandomStream(config.seed).split(RandomStreams::SHOOTERS).split(i)));
+    // Участники запускаются не одновременно
+    peers[i].accumulator = -0.0037 * i;
+  }
+  for (int i = 0; i < config.peers; i++) {
+    for (int j = 0; j < config.peers; j++) {
+      NetAddress address;
+      NetAddress::parse("127.0.0.1:" +
+                            std::to_string(peers[j].session->getPort()),
+                        address);
+      peers[i].session->setPeerAddress(j, address);
+    }
+  }
+
+  // Сеть может застрять насовсем только из-за ошибки в протоколе
+  double timeLimit = config.maxTicks * tickDuration * 4.0 + 10.0;
+  double now = 0.0;
+  bool running = true;
+  while (running && now < timeLimit) {
+    now += CLOCK_STEP;
+    for (NetPeer &peer : peers)
+      peer.session->receivePackets(now);
+
+    running = false;
+    for (int i = 0; i < config.peers; i++) {
+      NetPeer &peer = peers[i];
+      if (peer.done)
+        continue;
+      running = true;
+      peer.accumulator += CLOCK_STEP;
+      while (!peer.done && peer.accumulator >= tickDuration) {
+        // Как в игре: пока ждем сеть, время не копится, иначе после
+        // простоя участник рывком догонял бы пропущенные тики
+        if (!stepPeer(config, peer, i, tickDuration, now)) {
+          peer.stalled += CLOCK_STEP;
+          peer.accumulator = tickDuration;
+          break;
+        }
+        peer.accumulator -= tickDuration;
+      }
+    }
+
+    // Закончившие тоже отвечают: их ввод и подтверждения нужны остальным
+    for (NetPeer &peer : peers)
+      peer.session->sendPackets(now);
+  }
+
+  std::printf("%d peers, delay %d ticks, latency %.0f ms +- %.0f ms, "
+              "loss %.0f%%, seed %" PRIu64 "\n",
+              config.peers, config.delay, config.link.latency * 1000,
+              config.link.jitter * 1000, config.link.loss * 100, config.seed);
+
+  bool sameHash = true;
+  bool allDetected = true;
+  bool anyDetected = false;
+  for (int i = 0; i < config.peers; i++) {
+    const NetPeer &peer = peers[i];
+    const LockstepStats &stats = peer.session->getStats();
+    int ticks = peer.session->getTick();
+    sameHash = sameHash && peer.simulation->stateHash() ==
+                               peers[0].simulation->stateHash();
+    int desync = peer.session->getDesyncTick();
+    allDetected = allDetected && desync >= 0;
+    anyDetected = anyDetected || desync >= 0;
+
+    std::printf("peer %d: %d ticks%s, hash %016" PRIx64 ", %.1f B/tick in "
+                "%" PRIu64 " packets, stalled %.1f%%, ack %.0f +- %.0f ms, "
+                "suggested delay %d",
+                i, ticks, peer.simulation->isGameOver() ? " (game over)" : "",
+                peer.simulation->stateHash(),
+                ticks > 0 ? static_cast<double>(stats.bytesSent) / ticks : 0.0,
+                stats.packetsSent,
+                100.0 * peer.stalled / now,
+                stats.roundTrip * 1000, stats.roundTripDeviation * 1000,
+                stats.suggestedDelay);
+    if (desync >= 0)
+      std::printf(", DESYNC after tick %d", desync);
+    if (stats.badPackets > 0)
+      std::printf(", %" PRIu64 " bad packets", stats.badPackets);
+    std::printf("\n");
+  }
+
+  if (running) {
+    std::printf("network stalled for good at %.1f s\n", now);
+    return 1;
+  }
+  if (config.injectDesync >= 0) {
+    std::printf("injected desync %s\n",
+                allDetected ? "detected by every peer" : "NOT DETECTED");
+    return allDetected ? 0 : 1;
+  }
+  std::printf("end state %s, %s\n", sameHash ? "identical" : "DIFFERS",
+              anyDetected ? "desync reported" : "no desync reported");
+  return sameHash && !anyDetected ? 0 : 1;
+}
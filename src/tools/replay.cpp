@@ -0,0 +1,192 @@
+// Безголовое воспроизведение записей матчей с максимальной скоростью.
+//
+//   replay [--snapshots N] file [file...]
+//
+// Каждая запись проигрывается заново из seed и ввода по тикам, после
+// чего хеш состояния сравнивается с записанным. Код возврата 1, если
+// хоть одна запись не читается или разошлась с оригиналом. Просмотр с
+// отрисовкой — sfml-app --replay file --speed N.
+//
+// С --snapshots каждые N тиков снимается копия симуляции и двоичный
+// снимок. Оба восстанавливаются в отдельную симуляцию и доигрываются до
+// следующей точки: хеш должен совпасть с основным прогоном (проверка
+// отката). Печатаются размер и время снятия и восстановления снимков.
+#include "../game/Replay.hpp"
+#include "../game/Simulation.hpp"
+#include "../terrain/MapFile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double microseconds(Clock::time_point from, Clock::time_point to) {
+  return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+std::unique_ptr<Simulation> createSimulation(const std::string &path,
+                                             const ReplayHeader &header) {
+  if (header.mapPath.empty())
+    return std::unique_ptr<Simulation>(
+        new Simulation(header.worldWidth, header.worldHeight, header.seed,
+                       header.battle));
+  auto map = std::make_shared<MapFile>();
+  if (!map->open(header.mapPath)) {
+    std::fprintf(stderr, "%s: map %s is missing or invalid\n", path.c_str(),
+                 header.mapPath.c_str());
+    return nullptr;
+  }
+  return std::unique_ptr<Simulation>(
+      new Simulation(map, header.seed, header.battle));
+}
+
+struct Checkpoint {
+  int tick;
+  std::uint64_t hash;
+  Simulation copy;
+  ByteWriter snapshot;
+};
+
+// Каждый снимок доигрывается до следующей точки двумя способами: из копии
+// в памяти и из двоичного снимка, прочитанного в отдельную симуляцию
+bool checkSnapshots(const std::string &path, const ReplayHeader &header,
+                    const std::vector<PlayerInput> &inputs,
+                    const std::vector<Checkpoint> &checkpoints,
+                    std::uint64_t finalHash, double copyMicros,
+                    double writeMicros) {
+  std::unique_ptr<Simulation> restored = createSimulation(path, header);
+  if (!restored || checkpoints.empty())
+    return restored != nullptr;
+
+  int failed = 0;
+  double readMicros = 0.0;
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < checkpoints.size(); i++) {
+    const Checkpoint &checkpoint = checkpoints[i];
+    bytes += checkpoint.snapshot.size();
+    ByteReader reader(checkpoint.snapshot.data().data(),
+                      checkpoint.snapshot.size());
+    auto readStart = Clock::now();
+    bool read = restored->readSnapshot(reader);
+    readMicros += microseconds(readStart, Clock::now());
+    if (!read) {
+      std::fprintf(stderr, "%s: snapshot at tick %d does not read back\n",
+                   path.c_str(), checkpoint.tick);
+      failed++;
+      continue;
+    }
+
+    Simulation fromCopy(checkpoint.copy);
+    int end = i + 1 < checkpoints.size() ? checkpoints[i + 1].tick
+                                         : static_cast<int>(inputs.size());
+    for (int tick = checkpoint.tick; tick < end; tick++) {
+      restored->step(inputs[tick], header.tickDuration);
+      fromCopy.step(inputs[tick], header.tickDuration);
+    }
+    std::uint64_t expected =
+        i + 1 < checkpoints.size() ? checkpoints[i + 1].hash : finalHash;
+    if (restored->stateHash() != expected || fromCopy.stateHash() != expected) {
+      std::fprintf(stderr, "%s: run from snapshot at tick %d diverges\n",
+                   path.c_str(), checkpoint.tick);
+      failed++;
+    }
+  }
+
+  double count = static_cast<double>(checkpoints.size());
+  std::printf("%s: %zu snapshots, %.0f bytes each, copy %.1f us, "
+              "write %.1f us, read %.1f us, %d diverged\n",
+              path.c_str(), checkpoints.size(), bytes / count,
+              copyMicros / count, writeMicros / count, readMicros / count,
+              failed);
+  return failed == 0;
+}
+
+bool replayFile(const std::string &path, int snapshotEvery) {
+  ReplayReader replay;
+  if (!replay.load(path)) {
+    std::fprintf(stderr, "%s: not a valid replay file\n", path.c_str());
+    return false;
+  }
+  const ReplayHeader &header = replay.getHeader();
+
+  std::vector<PlayerInput> inputs;
+  PlayerInput input;
+  while (replay.next(input))
+    inputs.push_back(input);
+  if (replay.getTicksRead() < replay.getTicks()) {
+    std::fprintf(stderr, "%s: input %s at tick %d of %d\n", path.c_str(),
+                 replay.isInputCorrupt() ? "is corrupt" : "ends early",
+                 replay.getTicksRead(), replay.getTicks());
+    return false;
+  }
+
+  auto started = Clock::now();
+  std::unique_ptr<Simulation> simulation = createSimulation(path, header);
+  if (!simulation)
+    return false;
+
+  std::vector<Checkpoint> checkpoints;
+  double copyMicros = 0.0, writeMicros = 0.0, pausedMicros = 0.0;
+  for (int tick = 0; tick < static_cast<int>(inputs.size()); tick++) {
+    if (snapshotEvery > 0 && tick > 0 && tick % snapshotEvery == 0) {
+      auto copyStart = Clock::now();
+      Checkpoint checkpoint{tick, 0, *simulation, ByteWriter()};
+      auto writeStart = Clock::now();
+      simulation->writeSnapshot(checkpoint.snapshot);
+      auto writeEnd = Clock::now();
+      checkpoint.hash = simulation->stateHash();
+      checkpoints.push_back(std::move(checkpoint));
+      copyMicros += microseconds(copyStart, writeStart);
+      writeMicros += microseconds(writeStart, writeEnd);
+      pausedMicros += microseconds(copyStart, Clock::now());
+    }
+    simulation->step(inputs[tick], header.tickDuration);
+  }
+  double wallSeconds =
+      (microseconds(started, Clock::now()) - pausedMicros) / 1e6;
+
+  bool match = simulation->stateHash() == replay.getFinalHash();
+  double simSeconds = replay.getTicks() * header.tickDuration;
+  std::printf("%s: %d ticks (%.1f s) in %.3f s, %.0fx real time, "
+              "end state %s\n",
+              path.c_str(), replay.getTicks(), simSeconds, wallSeconds,
+              wallSeconds > 0.0 ? simSeconds / wallSeconds : 0.0,
+              match ? "OK" : "MISMATCH");
+
+  if (snapshotEvery > 0)
+    match = checkSnapshots(path, header, inputs, checkpoints,
+                           simulation->stateHash(), copyMicros,
+                           writeMicros) &&
+            match;
+  return match;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  int snapshotEvery = 0;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--snapshots" && i + 1 < argc) {
+      snapshotEvery = std::max(1, std::atoi(argv[++i]));
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty()) {
+    std::fprintf(stderr, "usage: %s [--snapshots N] file [file...]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  bool ok = true;
+  for (const std::string &file : files)
+    ok = replayFile(file, snapshotEvery) && ok;
+  return ok ? 0 : 1;
+}
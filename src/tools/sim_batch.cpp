@@ -0,0 +1,267 @@
+// Пакетный прогон безголовых матчей для балансировки оружия.
+//
+//   sim-batch [--matches N] [--threads T] [--seed S]
+//             [--policy random|aimed|search] [--teams N] [--worms M]
+//             [--world WxH | --map file] [--max-ticks K] [--csv file]
+//   sim-batch --save-map file [--seed S] [--world WxH]
+//
+// С --map все матчи идут на одной карте из файла, иначе каждый матч
+// генерирует свою. --save-map сохраняет карту, сгенерированную из seed.
+//
+// Политика search наводится перебором AimSolver в потоке матча и без
+// ограничения по времени, чтобы итог не зависел от загрузки машины.
+#include "../ai/AimSolver.hpp"
+#include "../ai/ScriptedShooter.hpp"
+#include "../game/Simulation.hpp"
+#include "../terrain/MapFile.hpp"
+#include "../terrain/SurfaceIndex.hpp"
+#include "../terrain/TerrainManager.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/ThreadPool.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+struct BatchConfig {
+  int matches = 1000;
+  int threads = 0;
+  std::uint64_t seed = 1;
+  ScriptedShooter::Mode policy = ScriptedShooter::Mode::AIMED;
+  BattleConfig battle;
+  int worldWidth = GameTypes::WORLD_WIDTH;
+  int worldHeight = GameTypes::WORLD_HEIGHT;
+  int maxTicks = 60 * 60 * 10; // 10 минут игрового времени
+  std::string csvPath;
+  std::string mapPath;
+  std::string saveMapPath;
+  std::shared_ptr<const MapFile> map; // открывается один раз на все матчи
+};
+
+struct MatchResult {
+  std::uint64_t seed = 0;
+  int winnerTeam = -1; // -1 — ничья или матч не закончился
+  int ticks = 0;
+  MatchStats stats;
+};
+
+const char *WEAPON_NAMES[GameTypes::WEAPON_COUNT] = {"bazooka", "sniper",
+                                                     "frag"};
+
+MatchResult playMatch(const BatchConfig &config, int matchIndex) {
+  // Каждый матч получает свой seed, и по нему воспроизводится целиком
+  std::uint64_t matchSeed =
+      RandomStream(config.seed).split(matchIndex).nextU64();
+  Simulation simulation =
+      config.map ? Simulation(config.map, matchSeed, config.battle)
+                 : Simulation(config.worldWidth, config.worldHeight,
+                              matchSeed, config.battle);
+  AimSolver::Config solverConfig;
+  solverConfig.timeBudget = 0.0f;
+  AimSolver solver(nullptr, solverConfig);
+  ScriptedShooter shooter(
+      config.policy, RandomStream(matchSeed).split(RandomStreams::SHOOTERS),
+      &solver);
+  float tickDuration = 1.0f / GameTypes::SIM_TICK_RATE;
+
+  MatchResult result;
+  result.seed = matchSeed;
+  while (!simulation.isGameOver() && result.ticks < config.maxTicks) {
+    simulation.step(shooter.decide(simulation), tickDuration);
+    result.ticks++;
+  }
+
+  if (simulation.isGameOver())
+    result.winnerTeam = simulation.getWinner();
+  result.stats = simulation.getStats();
+  return result;
+}
+
+bool parseArgs(int argc, char **argv, BatchConfig &config) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--matches" && hasValue) {
+      config.matches = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      config.threads = std::atoi(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      config.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--teams" && hasValue) {
+      config.battle.teams = std::atoi(argv[++i]);
+    } else if (arg == "--worms" && hasValue) {
+      config.battle.wormsPerTeam = std::atoi(argv[++i]);
+    } else if (arg == "--world" && hasValue) {
+      if (std::sscanf(argv[++i], "%dx%d", &config.worldWidth,
+                      &config.worldHeight) != 2)
+        return false;
+    } else if (arg == "--max-ticks" && hasValue) {
+      config.maxTicks = std::atoi(argv[++i]);
+    } else if (arg == "--map" && hasValue) {
+      config.mapPath = argv[++i];
+    } else if (arg == "--save-map" && hasValue) {
+      config.saveMapPath = argv[++i];
+    } else if (arg == "--csv" && hasValue) {
+      config.csvPath = argv[++i];
+    } else if (arg == "--policy" && hasValue) {
+      std::string policy = argv[++i];
+      if (policy == "random") {
+        config.policy = ScriptedShooter::Mode::RANDOM;
+      } else if (policy == "aimed") {
+        config.policy = ScriptedShooter::Mode::AIMED;
+      } else if (policy == "search") {
+        config.policy = ScriptedShooter::Mode::SEARCH;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return config.matches > 0 && config.battle.isValid() &&
+         config.worldWidth >= 400 &&
+         config.worldWidth <= SurfaceIndex::MAX_WIDTH &&
+         config.worldHeight >= 300 &&
+         config.worldHeight <= SurfaceIndex::MAX_HEIGHT;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  BatchConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    std::fprintf(stderr,
+                 "usage: %s [--matches N] [--threads T] [--seed S] "
+                 "[--policy random|aimed|search] [--teams N] [--worms M] "
+                 "[--world WxH | --map file] [--max-ticks K] [--csv file]\n"
+                 "       %s --save-map file [--seed S] [--world WxH]\n",
+                 argv[0], argv[0]);
+    return 1;
+  }
+
+  if (!config.saveMapPath.empty()) {
+    ThreadPool pool(config.threads);
+    auto generateStart = std::chrono::steady_clock::now();
+    TerrainManager terrain(
+        config.worldWidth, config.worldHeight,
+        RandomStream(config.seed).split(RandomStreams::TERRAIN), &pool);
+    auto saveStart = std::chrono::steady_clock::now();
+    if (!terrain.saveMap(config.saveMapPath)) {
+      std::perror(config.saveMapPath.c_str());
+      return 1;
+    }
+    auto saveEnd = std::chrono::steady_clock::now();
+    std::printf("map            %dx%d generated in %.1f ms, saved in %.1f ms\n",
+                config.worldWidth, config.worldHeight,
+                std::chrono::duration<double, std::milli>(saveStart -
+                                                          generateStart)
+                    .count(),
+                std::chrono::duration<double, std::milli>(saveEnd - saveStart)
+                    .count());
+    return 0;
+  }
+
+  if (!config.mapPath.empty()) {
+    auto loadStart = std::chrono::steady_clock::now();
+    auto map = std::make_shared<MapFile>();
+    if (!map->open(config.mapPath)) {
+      std::fprintf(stderr, "%s: not a valid map file\n",
+                   config.mapPath.c_str());
+      return 1;
+    }
+    config.map = map;
+    TerrainManager terrain(config.map);
+    std::printf("map            %dx%d opened and decoded in %.1f ms\n",
+                map->getWidth(), map->getHeight(),
+                std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - loadStart)
+                    .count());
+  }
+
+  std::vector<MatchResult> results(config.matches);
+  auto started = std::chrono::steady_clock::now();
+  int threadCount;
+  {
+    ThreadPool pool(config.threads);
+    threadCount = pool.getThreadCount();
+    for (int i = 0; i < config.matches; i++) {
+      pool.submit([&config, &results, i] { results[i] = playMatch(config, i); });
+    }
+    pool.wait();
+  }
+  double wallSeconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - started)
+                           .count();
+
+  // Сводка по всем матчам
+  long long totalTurns = 0;
+  double totalSimTime = 0.0;
+  long long shots[GameTypes::WEAPON_COUNT] = {};
+  long long damage[GameTypes::WEAPON_COUNT] = {};
+  std::vector<int> wins(config.battle.teams, 0);
+  int unfinished = 0;
+  for (const auto &result : results) {
+    totalTurns += result.stats.turns;
+    totalSimTime += result.stats.simTime;
+    for (int w = 0; w < GameTypes::WEAPON_COUNT; w++) {
+      shots[w] += result.stats.shotsByWeapon[w];
+      damage[w] += result.stats.damageByWeapon[w];
+    }
+    if (result.winnerTeam >= 0) {
+      wins[result.winnerTeam]++;
+    } else {
+      unfinished++;
+    }
+  }
+
+  std::printf("matches        %d (threads %d), %d teams x %d worms\n",
+              config.matches, threadCount, config.battle.teams,
+              config.battle.wormsPerTeam);
+  std::printf("wins          ");
+  for (int t = 0; t < config.battle.teams; t++)
+    std::printf(" team%d %d,", t, wins[t]);
+  std::printf(" no winner %d\n", unfinished);
+  std::printf("turns          %lld (%.1f per match)\n", totalTurns,
+              static_cast<double>(totalTurns) / config.matches);
+  std::printf("sim time       %.0f s (%.1f s per match)\n", totalSimTime,
+              totalSimTime / config.matches);
+  for (int w = 0; w < GameTypes::WEAPON_COUNT; w++) {
+    std::printf("%-14s %lld shots, %.2f damage per shot\n", WEAPON_NAMES[w],
+                shots[w],
+                shots[w] ? static_cast<double>(damage[w]) / shots[w] : 0.0);
+  }
+  std::printf("wall time      %.2f s, %.0f turns/hour, %.0fx real time\n",
+              wallSeconds, totalTurns / wallSeconds * 3600.0,
+              totalSimTime / wallSeconds);
+
+  if (!config.csvPath.empty()) {
+    FILE *csv = std::fopen(config.csvPath.c_str(), "w");
+    if (!csv) {
+      std::perror(config.csvPath.c_str());
+      return 1;
+    }
+    std::fprintf(csv, "match,seed,winner,turns,ticks,sim_time");
+    for (int w = 0; w < GameTypes::WEAPON_COUNT; w++)
+      std::fprintf(csv, ",%s_shots,%s_damage", WEAPON_NAMES[w],
+                   WEAPON_NAMES[w]);
+    std::fprintf(csv, "\n");
+    for (int i = 0; i < config.matches; i++) {
+      const MatchResult &result = results[i];
+      std::fprintf(csv, "%d,%llu,%d,%d,%d,%.3f", i,
+                   static_cast<unsigned long long>(result.seed),
+                   result.winnerTeam, result.stats.turns, result.ticks,
+                   result.stats.simTime);
+      for (int w = 0; w < GameTypes::WEAPON_COUNT; w++)
+        std::fprintf(csv, ",%d,%d", result.stats.shotsByWeapon[w],
+                     result.stats.damageByWeapon[w]);
+      std::fprintf(csv, "\n");
+    }
+    std::fclose(csv);
+  }
+  return 0;
+}
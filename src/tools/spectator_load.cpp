@@ -0,0 +1,339 @@
+// Нагрузочная проверка сервера трансляции: матч ботов транслируется
+// множеству зрителей в том же процессе.
+//
+//   spectator-load [--clients N] [--local] [--ticks K] [--rate HZ]
+//                  [--seed S] [--teams N] [--worms M] [--verify V]
+//
+// Сервер с матчем живет в своем потоке и идет со скоростью --rate тиков
+// в секунду (0 — без пауз), зрители читают в другом. --local — локальный
+// сокет вместо TCP. Первые V зрителей разбирают поток и ведут свою копию
+// местности, половина из них подключается посреди матча; в конце их
+// состояние сверяется с сервером. Печатаются время процессора сервера на
+// зрителя за тик, размеры кадров и байты на зрителя.
+#include "../ai/ScriptedShooter.hpp"
+#include "../game/Simulation.hpp"
+#include "../net/Spectator.hpp"
+#include "../net/SpectatorServer.hpp"
+#include "../utils/GameTypes.hpp"
+#include "../utils/Random.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+  int clients = 1000;
+  bool local = false;
+  int ticks = 600;
+  int rate = GameTypes::SIM_TICK_RATE;
+  std::uint64_t seed = 1;
+  BattleConfig battle;
+  int verify = 4;
+};
+
+struct Spectator {
+  int handle = -1;
+  std::uint64_t bytes = 0;
+  std::unique_ptr<SpectatorView> view; // только у сверяемых
+  bool broken = false;
+};
+
+double threadCpuSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int connectTo(const LoadConfig &config, std::uint16_t port,
+              const std::string &path) {
+  int handle;
+  int result;
+  if (config.local) {
+    handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    result = connect(handle, reinterpret_cast<sockaddr *>(&address),
+                     sizeof(address));
+  } else {
+    handle = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    result = connect(handle, reinterpret_cast<sockaddr *>(&address),
+                     sizeof(address));
+  }
+  if (handle < 0 || result != 0) {
+    if (handle >= 0)
+      close(handle);
+    return -1;
+  }
+  fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK);
+  return handle;
+}
+
+// Читает все, что пришло; false — ничего не пришло
+bool readSpectators(std::vector<Spectator> &spectators,
+                    std::vector<pollfd> &polls, int timeoutMs) {
+  polls.clear();
+  for (const Spectator &spectator : spectators) {
+    if (spectator.handle >= 0)
+      polls.push_back({spectator.handle, POLLIN, 0});
+  }
+  if (::poll(polls.data(), polls.size(), timeoutMs) <= 0)
+    return false;
+
+  static std::uint8_t buffer[1 << 16];
+  std::size_t next = 0;
+  for (Spectator &spectator : spectators) {
+    if (spectator.handle < 0)
+      continue;
+    const pollfd &entry = polls[next++];
+    if (!(entry.revents & (POLLIN | POLLHUP | POLLERR)))
+      continue;
+    for (;;) {
+      ssize_t size = read(spectator.handle, buffer, sizeof(buffer));
+      if (size <= 0)
+        break;
+      spectator.bytes += static_cast<std::uint64_t>(size);
+      if (spectator.view && !spectator.broken &&
+          !spectator.view->receive(buffer, static_cast<std::size_t>(size)))
+        spectator.broken = true;
+    }
+  }
+  return true;
+}
+
+// Зритель видит то же, что сервер после последнего тика
+bool matches(const SpectatorView &view, const Simulation &simulation,
+             int ticks) {
+  const SpectatorState &state = view.getState();
+  if (!view.hasKeyframe() || state.tick != ticks ||
+      state.worms.size() != simulation.getWorms().size() ||
+      state.currentPlayer != simulation.getCurrentPlayer() ||
+      state.gameOver != simulation.isGameOver())
+    return false;
+  for (std::size_t i = 0; i < state.worms.size(); i++) {
+    const Worm &worm = simulation.getWorms()[i];
+    if (state.worms[i].position != worm.position ||
+        state.worms[i].health != std::max(worm.health, 0) ||
+        state.worms[i].active != worm.isActive)
+      return false;
+  }
+
+  // Местность: журнал и выборка точек сетки
+  const TerrainManager *terrain = view.getTerrain();
+  const TerrainManager &original = simulation.getTerrain();
+  if (!terrain ||
+      terrain->getDestructionsHash() != original.getDestructionsHash())
+    return false;
+  RandomStream points(ticks);
+  for (int i = 0; i < 100000; i++) {
+    int x = points.uniformInt(0, original.getWidth() - 1);
+    int y = points.uniformInt(0, original.getHeight() - 1);
+    if (terrain->isColliding(x, y) != original.isColliding(x, y))
+      return false;
+  }
+  return true;
+}
+
+bool parseArgs(int argc, char **argv, LoadConfig &config) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--local") {
+      config.local = true;
+      continue;
+    }
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+    if (arg == "--clients") {
+      config.clients = std::max(1, std::atoi(value));
+    } else if (arg == "--ticks") {
+      config.ticks = std::max(1, std::atoi(value));
+    } else if (arg == "--rate") {
+      config.rate = std::max(0, std::atoi(value));
+    } else if (arg == "--seed") {
+      config.seed = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--teams") {
+      config.battle.teams = std::max(2, std::atoi(value));
+    } else if (arg == "--worms") {
+      config.battle.wormsPerTeam = std::max(1, std::atoi(value));
+    } else if (arg == "--verify") {
+      config.verify = std::max(0, std::atoi(value));
+    } else {
+      return false;
+    }
+  }
+  config.verify = std::min(config.verify, config.clients);
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  LoadConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    std::fprintf(stderr,
+                 "usage: %s [--clients N] [--local] [--ticks K] [--rate HZ] "
+                 "[--seed S] [--teams N] [--worms M] [--verify V]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  // По два дескриптора на зрителя: его сокет и сокет на стороне сервера
+  rlimit files;
+  getrlimit(RLIMIT_NOFILE, &files);
+  files.rlim_cur = files.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &files);
+
+  SpectatorServer server;
+  std::string path = "/tmp/spectator-load-" + std::to_string(getpid());
+  if (config.local ? !server.listenLocal(path) : !server.listenTcp(0)) {
+    std::perror("spectator-load: cannot listen");
+    return 1;
+  }
+
+  Simulation simulation(GameTypes::WORLD_WIDTH, GameTypes::WORLD_HEIGHT,
+                        config.seed, config.battle);
+  ScriptedShooter bot(
+      ScriptedShooter::Mode::AIMED,
+      RandomStream(config.seed).split(RandomStreams::SHOOTERS));
+  float tickDuration = 1.0f / GameTypes::SIM_TICK_RATE;
+
+  // Сверяемые зрители через одного подключаются посреди матча
+  std::vector<Spectator> spectators(config.clients);
+  for (int i = 0; i < config.verify; i++)
+    spectators[i].view.reset(new SpectatorView());
+  for (int i = 0; i < config.clients; i++) {
+    if (i < config.verify && i % 2 == 1)
+      continue;
+    spectators[i].handle = connectTo(config, server.getTcpPort(), path);
+    if (spectators[i].handle < 0) {
+      std::fprintf(stderr, "spectator-load: connect %d failed: %s\n", i,
+                   std::strerror(errno));
+      return 1;
+    }
+    // Очередь приема сервера не бесконечна
+    if (i % 256 == 255)
+      server.poll(simulation);
+  }
+  server.poll(simulation);
+
+  std::atomic<int> serverTick(0);
+  std::atomic<bool> serverDone(false);
+  double serverCpu = 0.0;
+  int ticks = 0;
+  std::thread serverThread([&]() {
+    double cpuStart = threadCpuSeconds();
+    auto next = Clock::now();
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.rate > 0 ? 1.0 / config.rate
+                                                      : 0.0));
+    for (ticks = 0; ticks < config.ticks && !simulation.isGameOver();) {
+      simulation.step(bot.decide(simulation), tickDuration);
+      server.broadcast(simulation);
+      server.poll(simulation);
+      serverTick = ++ticks;
+      if (config.rate > 0) {
+        next += period;
+        std::this_thread::sleep_until(next);
+      }
+    }
+    // Досылаем хвост очередей
+    auto deadline = Clock::now() + std::chrono::seconds(10);
+    while (server.getQueuedBytes() > 0 && Clock::now() < deadline) {
+      server.poll(simulation);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    serverCpu = threadCpuSeconds() - cpuStart;
+    serverDone = true;
+  });
+
+  std::vector<pollfd> polls;
+  bool lateJoined = false;
+  double clientCpuStart = threadCpuSeconds();
+  for (;;) {
+    if (!lateJoined && serverTick >= config.ticks / 2) {
+      lateJoined = true;
+      for (int i = 1; i < config.verify; i += 2)
+        spectators[i].handle = connectTo(config, server.getTcpPort(), path);
+    }
+    bool received = readSpectators(spectators, polls, 5);
+    if (serverDone && !received)
+      break;
+  }
+  double clientCpu = threadCpuSeconds() - clientCpuStart;
+  serverThread.join();
+
+  const SpectatorServerStats &stats = server.getStats();
+  std::uint64_t totalBytes = 0;
+  for (const Spectator &spectator : spectators)
+    totalBytes += spectator.bytes;
+  double matchSeconds = ticks * tickDuration;
+  double clientTicks = static_cast<double>(config.clients) * ticks;
+
+  std::printf("%d %s spectators, %d ticks (%.1f s of match)%s\n",
+              config.clients, config.local ? "local" : "TCP", ticks,
+              matchSeconds, simulation.isGameOver() ? ", game over" : "");
+  std::printf("server: %.3f s CPU, %.2f us per spectator per tick "
+              "(encode %.1f us per tick, fan-out %.2f us wall per spectator "
+              "per tick)\n",
+              serverCpu, 1e6 * serverCpu / clientTicks,
+              1e6 * stats.encodeSeconds / std::max(ticks, 1),
+              1e6 * stats.fanOutSeconds / clientTicks);
+  std::printf("frames: %" PRIu64 " encoded once (%.1f B avg), %" PRIu64
+              " keyframes, %" PRIu64 " queued references, %" PRIu64
+              " send calls, %" PRIu64 " resyncs, %" PRIu64 " disconnects\n",
+              stats.framesEncoded,
+              static_cast<double>(stats.bytesEncoded) / stats.framesEncoded,
+              stats.keyframes, stats.framesQueued, stats.sendCalls,
+              stats.resyncs, stats.disconnected);
+  std::printf("spectators: %.0f B each (%.0f B/s), readers used %.3f s "
+              "CPU\n",
+              static_cast<double>(totalBytes) / config.clients,
+              matchSeconds > 0 ? totalBytes / config.clients / matchSeconds
+                               : 0.0,
+              clientCpu);
+
+  int verified = 0, failed = 0;
+  for (const Spectator &spectator : spectators) {
+    if (!spectator.view)
+      continue;
+    verified++;
+    if (spectator.broken || !matches(*spectator.view, simulation, ticks))
+      failed++;
+  }
+  if (verified > 0)
+    std::printf("verified %d spectators (%d joined late): %s\n", verified,
+                verified / 2, failed == 0 ? "state matches the server"
+                                          : "STATE DIFFERS");
+
+  for (Spectator &spectator : spectators) {
+    if (spectator.handle >= 0)
+      close(spectator.handle);
+  }
+  return failed == 0 ? 0 : 1;
+}
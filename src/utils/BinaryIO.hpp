@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Little-endian запись чисел в байтовый буфер: файлы карт, записи матчей
+class ByteWriter {
+public:
+  void u8(std::uint8_t value) { buffer.push_back(value); }
+  void u32(std::uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      buffer.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+  }
+  void u64(std::uint64_t value) {
+    for (int i = 0; i < 8; i++)
+      buffer.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+  }
+  void f32(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u32(bits);
+  }
+  // LEB128: по 7 бит на байт, старший бит — продолжение
+  void varint(std::uint64_t value) {
+    while (value >= 0x80) {
+      buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+  }
+  // Знаковые числа зигзагом: малые по модулю занимают один байт
+  void svarint(std::int64_t value) {
+    varint((static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63));
+  }
+  void bytes(const void *data, std::size_t size) {
+    const std::uint8_t *begin = static_cast<const std::uint8_t *>(data);
+    buffer.insert(buffer.end(), begin, begin + size);
+  }
+  void string(const std::string &value) {
+    varint(value.size());
+    bytes(value.data(), value.size());
+  }
+
+  std::size_t size() const { return buffer.size(); }
+  const std::vector<std::uint8_t> &data() const { return buffer; }
+  void clear() { buffer.clear(); }
+
+private:
+  std::vector<std::uint8_t> buffer;
+};
+
+// Чтение того, что записал ByteWriter. Выход за конец данных не падает:
+// чтение возвращает ноль и взводит флаг ошибки, который проверяется один
+// раз после разбора.
+class ByteReader {
+public:
+  ByteReader(const std::uint8_t *data, std::size_t size)
+      : cursor(data), end(data + size), failed(false) {}
+
+  std::uint8_t u8() {
+    if (!require(1))
+      return 0;
+    return *cursor++;
+  }
+  std::uint32_t u32() {
+    if (!require(4))
+      return 0;
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+      value |= static_cast<std::uint32_t>(*cursor++) << (8 * i);
+    return value;
+  }
+  std::uint64_t u64() {
+    if (!require(8))
+      return 0;
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+      value |= static_cast<std::uint64_t>(*cursor++) << (8 * i);
+    return value;
+  }
+  float f32() {
+    std::uint32_t bits = u32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      std::uint8_t byte = u8();
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    failed = true;
+    return 0;
+  }
+  std::int64_t svarint() {
+    std::uint64_t value = varint();
+    return static_cast<std::int64_t>(value >> 1) ^
+           -static_cast<std::int64_t>(value & 1);
+  }
+  bool bytes(void *out, std::size_t size) {
+    if (!require(size))
+      return false;
+    std::memcpy(out, cursor, size);
+    cursor += size;
+    return true;
+  }
+  std::string string() {
+    std::uint64_t size = varint();
+    if (!require(size))
+      return std::string();
+    std::string value(reinterpret_cast<const char *>(cursor), size);
+    cursor += size;
+    return value;
+  }
+
+  bool ok() const { return !failed; }
+  bool atEnd() const { return cursor == end; }
+  std::size_t remaining() const { return end - cursor; }
+
+private:
+  bool require(std::uint64_t size) {
+    if (failed || size > static_cast<std::uint64_t>(end - cursor)) {
+      failed = true;
+      return false;
+    }
+    return true;
+  }
+
+  const std::uint8_t *cursor;
+  const std::uint8_t *end;
+  bool failed;
+};
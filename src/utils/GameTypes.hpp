@@ -1,13 +1,56 @@
 #pragma once
-#include <SFML/Graphics.hpp>
 
 namespace GameTypes {
 constexpr int WINDOW_WIDTH = 800;
 constexpr int WINDOW_HEIGHT = 600;
+// Размер карты по умолчанию; карта может быть больше окна
+constexpr int WORLD_WIDTH = 800;
+constexpr int WORLD_HEIGHT = 600;
 constexpr float GRAVITY = 800.0f;
 constexpr float PROJECTILE_GRAVITY = 600.0f;
 constexpr int WORM_RADIUS = 15;
 constexpr int PROJECTILE_RADIUS = 4;
 
+// Шаг симуляции фиксирован и не зависит от частоты кадров
+constexpr float SIM_TICK_RATE = 60.0f;
+constexpr int MAX_CATCH_UP_TICKS = 5;
+
 enum class WeaponType { BAZOOKA, SNIPER_RIFLE, FRAG_GRENADE };
+constexpr int WEAPON_COUNT = 3;
+
+// Снаряд появляется на этом расстоянии от центра червяка
+constexpr float MUZZLE_OFFSET = 25.0f;
+
+// Скорость вылета: базовая для оружия плюс 3 единицы на процент мощности
+constexpr float launchSpeed(WeaponType type, float aimPower) {
+  return (type == WeaponType::SNIPER_RIFLE   ? 800.0f
+          : type == WeaponType::FRAG_GRENADE ? 300.0f
+                                             : 400.0f) +
+         aimPower * 3.0f;
+}
+
+// Урон при прямом попадании и радиус взрыва снаряда
+constexpr int weaponDamage(WeaponType type) {
+  return type == WeaponType::SNIPER_RIFLE   ? 75
+         : type == WeaponType::FRAG_GRENADE ? 35
+                                            : 25;
+}
+
+constexpr int weaponExplosionRadius(WeaponType type) {
+  return type == WeaponType::SNIPER_RIFLE   ? 5
+         : type == WeaponType::FRAG_GRENADE ? 45
+                                            : 30;
+}
+
+// Точек в следе снаряда (не больше TrailArena::MAX_LENGTH): быстрая
+// пуля оставляет след длиннее, иначе он почти не виден
+constexpr int trailLength(WeaponType type) {
+  return type == WeaponType::SNIPER_RIFLE ? 24 : 15;
+}
+
+// Снайперская пуля меньше подвержена гравитации
+constexpr float projectileGravity(WeaponType type) {
+  return type == WeaponType::SNIPER_RIFLE ? PROJECTILE_GRAVITY * 0.3f
+                                          : PROJECTILE_GRAVITY;
+}
 } // namespace GameTypes
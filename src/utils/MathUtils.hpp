@@ -1,5 +1,5 @@
 #pragma once
-#include <SFML/Graphics.hpp>
+#include <SFML/System/Vector2.hpp>
 #include <cmath>
 
 namespace MathUtils {
@@ -18,4 +18,9 @@ inline sf::Vector2f normalize(const sf::Vector2f &vector) {
 inline float length(const sf::Vector2f &vector) {
   return std::sqrt(vector.x * vector.x + vector.y * vector.y);
 }
+
+// Обе координаты конечны и по модулю не больше limit (NaN не проходит)
+inline bool isWithin(const sf::Vector2f &vector, float limit) {
+  return std::fabs(vector.x) <= limit && std::fabs(vector.y) <= limit;
+}
 } // namespace MathUtils
@@ -0,0 +1,224 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace {
+constexpr int MAX_ZONES = 128;
+// Потолки записи на выход: около 50 МБ истории (больше часа при 60 кадрах
+// в секунду) и около 100 МБ вызовов; дальше запись просто обрывается
+constexpr std::size_t MAX_HISTORY_SAMPLES = std::size_t(1) << 22;
+constexpr std::size_t MAX_TRACE_EVENTS = std::size_t(1) << 22;
+
+struct ZoneData {
+  const char *name = nullptr;
+  std::int64_t frameNanos = 0;
+  int frameCalls = 0;
+  float window[Profiler::WINDOW_FRAMES] = {}; // мс за кадр, по кругу
+  std::uint16_t windowCalls[Profiler::WINDOW_FRAMES] = {};
+};
+
+struct FrameSample {
+  std::uint32_t frame;
+  std::uint16_t zone;
+  std::uint16_t calls;
+  float milliseconds;
+};
+
+struct TraceEvent {
+  int zone;
+  std::int64_t start; // нс от начала записи
+  std::int64_t duration;
+};
+
+// Зоны регистрируются из любого потока, пишет только записывающий: массив
+// фиксированный, чтобы регистрация не двигала данные под ним
+struct ProfilerState {
+  std::mutex registration;
+  ZoneData zones[MAX_ZONES];
+  std::atomic<int> zoneCount{0};
+
+  Profiler::Clock::time_point epoch = Profiler::Clock::now();
+  Profiler::Clock::time_point frameStart = epoch;
+  std::uint32_t frame = 0;
+  int windowPosition = 0;
+  int windowFilled = 0;
+
+  bool keepFrames = false;
+  bool keepTrace = false;
+  std::vector<FrameSample> history;
+  std::vector<TraceEvent> trace;
+};
+
+ProfilerState state;
+
+// Нулевая зона — кадр целиком, от одного endFrame() до следующего
+const int TOTAL_ZONE = Profiler::zone("total");
+
+std::int64_t nanosecondsBetween(Profiler::Clock::time_point from,
+                                Profiler::Clock::time_point to) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from)
+      .count();
+}
+
+// Имена зон — литералы из кода, но кавычки экранируем на всякий случай
+void writeJsonString(std::FILE *file, const char *text) {
+  std::fputc('"', file);
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\')
+      std::fputc('\\', file);
+    std::fputc(*text, file);
+  }
+  std::fputc('"', file);
+}
+
+bool writeCsv(std::FILE *file) {
+  int zoneCount = state.zoneCount;
+  std::fprintf(file, "frame");
+  for (int zone = 0; zone < zoneCount; zone++)
+    std::fprintf(file, ",%s_ms", state.zones[zone].name);
+  std::fputc('\n', file);
+
+  std::vector<float> row(zoneCount);
+  std::size_t next = 0;
+  while (next < state.history.size()) {
+    std::uint32_t frame = state.history[next].frame;
+    std::fill(row.begin(), row.end(), 0.0f);
+    for (; next < state.history.size() && state.history[next].frame == frame;
+         next++)
+      row[state.history[next].zone] = state.history[next].milliseconds;
+    std::fprintf(file, "%u", frame);
+    for (float value : row)
+      std::fprintf(file, ",%.4f", value);
+    std::fputc('\n', file);
+  }
+  return !std::ferror(file);
+}
+
+// Формат Trace Event: открывается в chrome://tracing и Perfetto
+bool writeTrace(std::FILE *file) {
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (std::size_t i = 0; i < state.trace.size(); i++) {
+    const TraceEvent &event = state.trace[i];
+    std::fprintf(file, "%s\n{\"name\":", i == 0 ? "" : ",");
+    writeJsonString(file, state.zones[event.zone].name);
+    std::fprintf(file,
+                 ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                 "\"tid\":1}",
+                 event.start / 1e3, event.duration / 1e3);
+  }
+  std::fprintf(file, "\n]}\n");
+  return !std::ferror(file);
+}
+} // namespace
+
+thread_local bool Profiler::recording = false;
+
+int Profiler::zone(const char *name) {
+  std::lock_guard<std::mutex> lock(state.registration);
+  int count = state.zoneCount;
+  for (int zone = 0; zone < count; zone++) {
+    if (std::strcmp(state.zones[zone].name, name) == 0)
+      return zone;
+  }
+  if (count == MAX_ZONES)
+    return -1;
+  state.zones[count].name = name;
+  state.zoneCount = count + 1;
+  return count;
+}
+
+void Profiler::recordThisThread() {
+  recording = true;
+  state.frameStart = Clock::now();
+}
+
+void Profiler::record(int zone, Clock::time_point start,
+                      Clock::time_point end) {
+  std::int64_t duration = nanosecondsBetween(start, end);
+  ZoneData &data = state.zones[zone];
+  data.frameNanos += duration;
+  data.frameCalls++;
+  if (state.keepTrace && state.trace.size() < MAX_TRACE_EVENTS)
+    state.trace.push_back(
+        {zone, nanosecondsBetween(state.epoch, start), duration});
+}
+
+void Profiler::endFrame() {
+  if (!recording)
+    return;
+  Clock::time_point now = Clock::now();
+  record(TOTAL_ZONE, state.frameStart, now);
+  state.frameStart = now;
+
+  int zoneCount = state.zoneCount;
+  int position = state.windowPosition;
+  for (int zone = 0; zone < zoneCount; zone++) {
+    ZoneData &data = state.zones[zone];
+    float milliseconds = static_cast<float>(data.frameNanos / 1e6);
+    data.window[position] = milliseconds;
+    data.windowCalls[position] = static_cast<std::uint16_t>(
+        std::min(data.frameCalls, 0xffff));
+    if (state.keepFrames && data.frameCalls > 0 &&
+        state.history.size() < MAX_HISTORY_SAMPLES)
+      state.history.push_back({state.frame, static_cast<std::uint16_t>(zone),
+                               data.windowCalls[position], milliseconds});
+    data.frameNanos = 0;
+    data.frameCalls = 0;
+  }
+  state.windowPosition = (position + 1) % WINDOW_FRAMES;
+  state.windowFilled = std::min(state.windowFilled + 1, WINDOW_FRAMES);
+  state.frame++;
+}
+
+void Profiler::keepHistory(bool frames, bool trace) {
+  state.keepFrames = frames;
+  state.keepTrace = trace;
+}
+
+std::vector<Profiler::ZoneSummary> Profiler::summary() {
+  std::vector<ZoneSummary> zones;
+  int filled = state.windowFilled;
+  if (filled == 0)
+    return zones;
+
+  std::vector<float> values(filled);
+  int zoneCount = state.zoneCount;
+  for (int zone = 0; zone < zoneCount; zone++) {
+    const ZoneData &data = state.zones[zone];
+    ZoneSummary entry;
+    entry.name = data.name;
+    int calls = 0;
+    for (int i = 0; i < filled; i++)
+      calls += data.windowCalls[i];
+    entry.callsPerFrame = static_cast<double>(calls) / filled;
+
+    // Порядок кадров в окне для перцентилей не важен
+    std::copy(data.window, data.window + filled, values.begin());
+    auto rank = [&](double share) {
+      std::size_t index = std::min(static_cast<std::size_t>(share * filled),
+                                   values.size() - 1);
+      std::nth_element(values.begin(), values.begin() + index, values.end());
+      return static_cast<double>(values[index]);
+    };
+    entry.p50 = rank(0.5);
+    entry.p99 = rank(0.99);
+    entry.max = *std::max_element(values.begin(), values.end());
+    zones.push_back(entry);
+  }
+  return zones;
+}
+
+bool Profiler::isTracePath(const std::string &path) {
+  return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+bool Profiler::write(const std::string &path) {
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+  bool written = isTracePath(path) ? writeTrace(file) : writeCsv(file);
+  return std::fclose(file) == 0 && written;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Профилировщик кадра по именованным зонам. Зона — область видимости,
+// помеченная PROFILE_ZONE("имя"): время ее выполнения копится за кадр,
+// PROFILE_FRAME() закрывает кадр. По каждой зоне хранится окно последних
+// кадров, из него считаются медиана, p99 и максимум; при желании пишется
+// история всех кадров (CSV) и все вызовы зон (Chrome trace).
+//
+// Собирается только с -DPROFILER (make PROFILE=1): без него макросы пустые
+// и зоны ничего не стоят. Записывается лишь поток, вызвавший
+// recordThisThread(), — в остальных (пул ИИ, пакетные прогоны) зона стоит
+// одной проверки флага. Вложенные зоны входят во время внешних.
+class Profiler {
+public:
+#ifdef PROFILER
+  static constexpr bool ENABLED = true;
+#else
+  static constexpr bool ENABLED = false;
+#endif
+  // Кадров в окне, по которому считаются перцентили
+  static constexpr int WINDOW_FRAMES = 600;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct ZoneSummary {
+    std::string name;
+    double p50 = 0.0; // мс за кадр, включая кадры без вызовов зоны
+    double p99 = 0.0;
+    double max = 0.0;
+    double callsPerFrame = 0.0;
+  };
+
+  // Номер зоны по имени; имя должно жить до конца программы
+  static int zone(const char *name);
+  static void recordThisThread();
+  static bool isRecording() { return recording; }
+  static void record(int zone, Clock::time_point start, Clock::time_point end);
+  static void endFrame();
+
+  // Помнить историю кадров и отдельные вызовы для записи на выходе
+  static void keepHistory(bool frames, bool trace);
+  // Первая строка — весь кадр, дальше зоны в порядке появления
+  static std::vector<ZoneSummary> summary();
+  // По расширению: .json — Chrome trace, иначе CSV по кадрам
+  static bool isTracePath(const std::string &path);
+  static bool write(const std::string &path);
+
+private:
+  static thread_local bool recording;
+};
+
+// Замер одной зоны от конструктора до деструктора
+class ProfileScope {
+public:
+  explicit ProfileScope(int zone) : zone(zone) {
+    if (Profiler::isRecording())
+      start = Profiler::Clock::now();
+    else
+      this->zone = -1;
+  }
+  ~ProfileScope() {
+    if (zone >= 0)
+      Profiler::record(zone, start, Profiler::Clock::now());
+  }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  int zone;
+  Profiler::Clock::time_point start;
+};
+
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+
+#ifdef PROFILER
+#define PROFILE_ZONE(name)                                                     \
+  static const int PROFILE_JOIN(profileZone, __LINE__) =                      \
+      Profiler::zone(name);                                                    \
+  ProfileScope PROFILE_JOIN(profileScope,                                      \
+                            __LINE__)(PROFILE_JOIN(profileZone, __LINE__))
+#define PROFILE_FRAME() Profiler::endFrame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+// Счетчиковый генератор случайных чисел: i-е значение потока — хеш от
+// (ключ + i). Состояние занимает два слова, не обращается к ядру и дает
+// одинаковые последовательности на любой платформе. Подпотоки выводятся
+// из ключа родителя и номера, так что матч воспроизводим по одному seed.
+class RandomStream {
+public:
+  explicit RandomStream(std::uint64_t seed = 0) : key(mix(seed)), counter(0) {}
+
+  // Поток ровно в том состоянии, которое вернули getKey() и getCounter()
+  static RandomStream fromState(std::uint64_t key, std::uint64_t counter) {
+    RandomStream stream;
+    stream.key = key;
+    stream.counter = counter;
+    return stream;
+  }
+
+  // Независимый подпоток: для подсистемы матча или отдельной сущности
+  RandomStream split(std::uint64_t streamId) const {
+    return RandomStream(key ^ mix(streamId + 0x632be59bd9b4e019ULL));
+  }
+
+  std::uint64_t nextU64() { return mix(key + (counter++) * GOLDEN_GAMMA); }
+
+  // [0, 1)
+  float nextFloat() {
+    return static_cast<float>(nextU64() >> 40) * (1.0f / 16777216.0f);
+  }
+
+  float uniform(float min, float max) { return min + (max - min) * nextFloat(); }
+
+  // [min, max] включительно
+  int uniformInt(int min, int max) {
+    std::uint64_t range = static_cast<std::uint64_t>(max - min) + 1;
+    return min + static_cast<int>(nextU64() % range);
+  }
+
+  std::uint64_t getKey() const { return key; }
+  std::uint64_t getCounter() const { return counter; }
+
+private:
+  static constexpr std::uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+  // Финализатор SplitMix64
+  static std::uint64_t mix(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  std::uint64_t key;
+  std::uint64_t counter;
+};
+
+// Номера подпотоков матча
+namespace RandomStreams {
+constexpr std::uint64_t TERRAIN = 1;
+constexpr std::uint64_t PROJECTILES = 2;
+constexpr std::uint64_t SHOOTERS = 3;
+} // namespace RandomStreams
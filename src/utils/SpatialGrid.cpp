@@ -0,0 +1,8 @@
+#include "SpatialGrid.hpp"
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float worldWidth, float worldHeight, float cellSize)
+    : columns(std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)))),
+      rows(std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)))),
+      inverseCell(1.0f / cellSize),
+      cellStart(static_cast<std::size_t>(columns) * rows + 1, 0) {}
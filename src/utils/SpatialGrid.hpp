@@ -0,0 +1,66 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Равномерная сетка для поиска соседей: точки раскладываются по ячейкам
+// подсчетом (counting sort), так что внутри ячейки номера идут по
+// возрастанию, а после прогрева перестройка не выделяет память. Точки за
+// пределами мира попадают в крайние ячейки.
+class SpatialGrid {
+public:
+  SpatialGrid(float worldWidth, float worldHeight, float cellSize);
+
+  // position(i) — координаты i-й точки, i < count
+  template <typename Position>
+  void rebuild(std::size_t count, Position position) {
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    cellOfItem.resize(count);
+    items.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      sf::Vector2f p = position(i);
+      int cell = cellY(p.y) * columns + cellX(p.x);
+      cellOfItem[i] = cell;
+      cellStart[cell + 1]++;
+    }
+    for (std::size_t c = 1; c < cellStart.size(); c++)
+      cellStart[c] += cellStart[c - 1];
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (std::size_t i = 0; i < count; i++)
+      items[cursor[cellOfItem[i]]++] = static_cast<std::uint32_t>(i);
+  }
+
+  // Вызывает visit(i) для точек из ячеек, задетых квадратом вокруг center.
+  // Это кандидаты: точное расстояние проверяет вызывающий.
+  template <typename Visit>
+  void forEachNear(sf::Vector2f center, float radius, Visit visit) const {
+    int x0 = cellX(center.x - radius), x1 = cellX(center.x + radius);
+    int y0 = cellY(center.y - radius), y1 = cellY(center.y + radius);
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        int cell = y * columns + x;
+        for (std::uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+          visit(items[k]);
+      }
+    }
+  }
+
+private:
+  int cellX(float x) const {
+    int cell = static_cast<int>(x * inverseCell);
+    return std::max(0, std::min(columns - 1, cell));
+  }
+  int cellY(float y) const {
+    int cell = static_cast<int>(y * inverseCell);
+    return std::max(0, std::min(rows - 1, cell));
+  }
+
+  int columns, rows;
+  float inverseCell;
+  std::vector<std::uint32_t> cellStart; // columns * rows + 1
+  std::vector<std::uint32_t> cursor;
+  std::vector<int> cellOfItem;
+  std::vector<std::uint32_t> items;
+};
@@ -0,0 +1,112 @@
+#include "ThreadPool.hpp"
+
+namespace {
+// Очередь текущего рабочего потока (-1 вне пула)
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local int currentWorker = -1;
+} // namespace
+
+ThreadPool::ThreadPool(int threadCount)
+    : queuedTasks(0), pendingTasks(0), stopping(false), nextQueue(0) {
+  if (threadCount <= 0)
+    threadCount = static_cast<int>(std::thread::hardware_concurrency());
+  if (threadCount <= 0)
+    threadCount = 1;
+
+  for (int i = 0; i < threadCount; i++)
+    queues.emplace_back(new WorkerQueue());
+  for (int i = 0; i < threadCount; i++)
+    threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+  // Задачи, порожденные внутри пула, кладем в свою очередь, остальные — по
+  // кругу, чтобы работа сразу оказалась распределенной
+  int index = currentPool == this
+                  ? currentWorker
+                  : static_cast<int>(nextQueue++ % queues.size());
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    queuedTasks++;
+    pendingTasks++;
+  }
+  workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(stateMutex);
+  allDone.wait(lock, [this] { return pendingTasks == 0; });
+}
+
+bool ThreadPool::popTask(int index, Task &task) {
+  // Свою очередь разбираем с конца (свежие задачи горячие в кеше)
+  {
+    WorkerQueue &own = *queues[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // Чужие — с начала, там самые старые и обычно самые крупные задачи
+  int count = static_cast<int>(queues.size());
+  for (int offset = 1; offset < count; offset++) {
+    WorkerQueue &victim = *queues[(index + offset) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+  currentPool = this;
+  currentWorker = index;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(stateMutex);
+      workAvailable.wait(lock,
+                         [this] { return stopping || queuedTasks > 0; });
+      if (stopping && queuedTasks == 0)
+        return;
+    }
+
+    Task task;
+    if (!popTask(index, task))
+      continue;
+    {
+      std::lock_guard<std::mutex> lock(stateMutex);
+      queuedTasks--;
+    }
+
+    task();
+
+    bool finished;
+    {
+      std::lock_guard<std::mutex> lock(stateMutex);
+      finished = --pendingTasks == 0;
+    }
+    if (finished)
+      allDone.notify_all();
+  }
+}
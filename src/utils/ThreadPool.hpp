@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом работы: у каждого потока своя очередь задач,
+// свободный поток забирает задачи из начала чужих очередей.
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  // 0 потоков — по числу ядер
+  explicit ThreadPool(int threadCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(Task task);
+  // Ждет завершения всех отправленных задач
+  void wait();
+
+  int getThreadCount() const { return static_cast<int>(threads.size()); }
+
+private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void workerLoop(int index);
+  bool popTask(int index, Task &task);
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> threads;
+
+  std::mutex stateMutex;
+  std::condition_variable workAvailable;
+  std::condition_variable allDone;
+  int queuedTasks;  // лежат в очередях
+  int pendingTasks; // отправлены и еще не завершены
+  bool stopping;
+  std::atomic<unsigned> nextQueue;
+};